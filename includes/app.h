@@ -6,6 +6,8 @@
 #include<SDL2/SDL.h>
 #include<SDL2/SDL_ttf.h>
 
+#include<pool.h>
+
 #define print(...) printf("[%s]: ", __func__); printf(__VA_ARGS__);
 
 enum EditingMode {
@@ -17,6 +19,22 @@ enum EditingMode {
     EM_AUTOROT
 };
 
+// Counters for one frame, reset before its task graph runs.
+typedef struct frame_stats {
+    int draw_calls;
+    int lines;
+    int cubes_culled;   // Whole cubes outside the view frustum
+    int edges_clipped;  // Edges shortened by the near plane or the screen edges
+    int edges_rejected; // Edges of visible cubes with nothing left on screen
+    double graph_ms;    // Running the frame's task graph, start to finish
+    double critical_ms; // Longest chain of dependent tasks in it
+    double work_ms;     // graph_ms less presenting, which may wait for the display
+    double render_scale;    // Of the window's width and height the scene was drawn at
+    int shed;           // enum GovernorStep, the last step of work the frame went without
+    int cubes_outlined; // Far cubes drawn as their outline, GOV_LOD
+    int blends_owed;    // Moving cubes left to blend on a later frame, GOV_AMORTIZE
+} frame_stats;
+
 typedef struct app_t {
     bool running;
     int screen_width;
@@ -26,9 +44,36 @@ typedef struct app_t {
 
     TTF_Font* font;
     double fov;
-    int cube_count;
-    int current_cube;
+    int cube_count; // --cubes, 0 keeps the default two cube scene
     enum EditingMode em;
+
+    const char* bench;
+    double hud_max_hz; // 0 re-formats the HUD every frame
+    const char* isa; // --isa, forces a kernel variant
+    int threads; // --threads, 0 uses every logical CPU
+    bool pin_threads; // --pin, keeps each job thread on its own logical CPU
+    bool morton; // --morton, keeps cube storage in Z-order
+    int backend; // enum RenderBackend, --backend or B to switch
+    const char* trace; // --trace, file for a Chrome trace of the first frames' task graphs
+    double sim_hz; // --sim-hz, simulation ticks per second
+    int sim_max_steps; // --sim-max-steps, ticks the simulation may run back to back to catch up
+    bool interpolate; // Off with --no-interp, frames then show the newest tick as is
+    int pace; // enum PaceMode, --pace or P to switch
+    double target_fps; // --fps, frame rate the timer pacing aims for
+    bool on_demand; // --on-demand or O, frames are only drawn when something changed
+    double render_scale; // --render-scale, fixed scale of the scene target, 1 is the window's size
+    bool dynamic_res; // --dynamic-res or R, the scale follows the frame budget instead
+    double frame_budget_ms; // --frame-budget, 0 uses the pacer's frame period
+    bool governor; // --governor or G, sheds work when frames are about to run over the budget
+    bool diagnostics; // D, the HUD lists frame diagnostics instead of the cubes
+
+    frame_stats stats;      // Frame being drawn
+    frame_stats last_stats; // Last completed frame, what the HUD reports
 } app_t;
 
+extern app_t* app;
+extern const double RAD_TO_DEG;
+// The renderer's mirror of the simulation, defined in main.c.
+extern cube_pool scene;
+
 #endif // _APP_H
\ No newline at end of file
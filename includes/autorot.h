@@ -0,0 +1,25 @@
+#ifndef _AUTOROT_H
+#define _AUTOROT_H
+
+#include<pool.h>
+#include<vmath.h>
+
+// Ticks between renormalizations of the incrementally rotated sin/cos pairs.
+#define AUTOROT_RENORM_TICKS 64
+
+#define TAU 6.283185307179586
+
+// Auto-rotation engine.
+// Each axis angle advances by a constant step per tick, so instead of re-evaluating sin/cos of the
+// new angle, the (cos, sin) pair is rotated by the precomputed (cos step, sin step) pair, a complex
+// multiply. Rounding slowly pulls the pair off the unit circle, hence the periodic renormalization.
+// Steady state needs no trig at all, only a change of tick length recomputes the steps.
+
+// Starts rotating a cube by `vel` radians per second around each axis, six trig calls once.
+void autorot_start(cube_pool* pool, int index, v3 vel);
+void autorot_stop(cube_pool* pool, int index);
+
+// Advances every auto-rotating cube by one tick of `dt` seconds.
+void autorot_tick(cube_pool* pool, double dt);
+
+#endif // _AUTOROT_H
@@ -0,0 +1,8 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+// Runs a named benchmark against the already initialized app and returns the process exit code.
+// Invoked with `app.exe --bench <name>`, `--bench list` prints the available names.
+int bench_run(const char* name);
+
+#endif // _BENCH_H
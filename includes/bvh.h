@@ -0,0 +1,69 @@
+#ifndef _BVH_H
+#define _BVH_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#include<clip.h>
+
+#define BVH_LEAF_SIZE 4
+
+typedef struct aabb {
+    float min[3];
+    float max[3];
+} aabb;
+
+// 32 bytes, two per cache line. Children always sit after their parent, so walking the array
+// backwards visits every child before its parent.
+typedef struct bvh_node {
+    aabb box;
+    int first;  // Leaf: first entry of `items`. Internal: left child, the right one is first + 1
+    int count;  // Cubes in a leaf, 0 for internal nodes
+} bvh_node;
+
+// Bounding volume hierarchy over the world space boxes of every cube in a pool.
+// Rebuilt whenever cubes are added or removed, refit bottom-up when only their model matrices changed.
+typedef struct bvh {
+    bvh_node* nodes;
+    int node_count;
+    int* parent;
+    Uint8* marked;
+
+    int* items;     // Dense cube indices, leaves own a range of it
+    int* leaf_of;   // Per cube, the leaf it sits in
+    aabb* boxes;    // Per cube
+    int cube_count;
+    int capacity;
+
+    Uint32 layout_version;  // Of the pool the tree was built for
+    bool built;
+
+    // Scratch for refits.
+    int* refit_nodes;
+
+    // What the last bvh_update() did.
+    bool rebuilt;
+    int refit_count;
+} bvh;
+
+struct cube_pool;
+
+void bvh_init(bvh* tree);
+void bvh_destroy(bvh* tree);
+
+// Full top-down build, splitting at the median along the longest axis.
+void bvh_build(bvh* tree, const struct cube_pool* pool);
+// Refreshes the boxes of the cubes the last pool_update_models() rebuilt, then only their ancestors.
+// Returns the number of nodes refit.
+int bvh_refit(bvh* tree, const struct cube_pool* pool);
+// Builds when the pool layout changed since the last build, refits otherwise.
+void bvh_update(bvh* tree, const struct cube_pool* pool);
+
+// Writes an enum CullResult for every cube into `visible`, skipping whole subtrees outside the frustum.
+// Returns the number of cubes culled.
+int bvh_cull(const bvh* tree, const frustum* view, Uint8* visible);
+
+// World space box of cube `index` from its model matrix.
+aabb bvh_cube_box(const struct cube_pool* pool, int index);
+
+#endif // _BVH_H
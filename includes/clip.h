@@ -0,0 +1,53 @@
+#ifndef _CLIP_H
+#define _CLIP_H
+
+#include<stdbool.h>
+
+#include<vmath.h>
+#include<lines.h>
+
+// Closest depth (fov + z) anything gets projected at, the divide is never guarded otherwise.
+#define CLIP_NEAR 1.0
+
+enum FrustumPlane {
+    PLANE_LEFT = 0,
+    PLANE_TOP,
+    PLANE_RIGHT,
+    PLANE_BOTTOM,
+    PLANE_NEAR,
+    PLANE_COUNT
+};
+
+// What a bounding sphere test says about a whole cube.
+enum CullResult {
+    CULL_OUTSIDE = 0,   // Nothing of it can reach the screen, skip all vertex work
+    CULL_INTERSECT,     // Partially visible, its edges need clipping
+    CULL_INSIDE         // Entirely in view, its edges go out as they are
+};
+
+enum ClipResult {
+    CLIP_ACCEPTED = 0,
+    CLIP_CLIPPED,
+    CLIP_REJECTED
+};
+
+// The pyramid from the eye at (0, 0, -fov) through the screen rectangle, cut off at CLIP_NEAR.
+// Points are inside when a * x + b * y + c * z + d >= 0 for every plane, normals are unit length.
+typedef struct frustum {
+    double fov;
+    float width;
+    float height;
+    bool enabled;   // Only a positive fov makes a frustum, otherwise every cube is treated as intersecting
+    double plane[PLANE_COUNT][4];
+} frustum;
+
+frustum frustum_make(double fov, int width, int height);
+enum CullResult frustum_test_sphere(const frustum* f, v3 center, double radius);
+enum CullResult frustum_test_aabb(const frustum* f, const float* min, const float* max);
+
+// Clips a world space edge against the near plane, then its projection against the screen rectangle
+// (Cohen-Sutherland). `pa`/`pb` are the already projected endpoints, only used when they are in front
+// of the near plane. The result is written to `out` unless the edge is rejected.
+enum ClipResult clip_edge(const frustum* f, v3 wa, v3 wb, float pax, float pay, float pbx, float pby, line_seg* out);
+
+#endif // _CLIP_H
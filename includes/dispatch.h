@@ -0,0 +1,41 @@
+#ifndef _DISPATCH_H
+#define _DISPATCH_H
+
+#include<stdbool.h>
+
+#include<xform.h>
+#include<trig.h>
+#include<raster.h>
+
+// Instruction set variants the kernels are built for, in order of preference.
+enum IsaLevel {
+    ISA_SCALAR = 0,
+    ISA_SSE2,
+    ISA_AVX2,
+    ISA_COUNT
+};
+
+// Kernel table, filled once at startup and read through `kern` everywhere else.
+typedef struct kernels {
+    enum IsaLevel isa;
+    const char* name;
+    xform_cubes_fn xform_cubes;
+    xform_points_fn xform_points;
+    project_fn project;
+    sincos_batch_fn sincos_poly;
+    raster_line_fn raster_line;
+} kernels;
+
+extern kernels kern;
+
+// Picks the widest variant the CPU supports. `force`, when not NULL, names the variant to use
+// instead, as long as the CPU can run it.
+void dispatch_init(const char* force);
+
+// Fills a table for a specific variant, false when the CPU cannot run it.
+bool dispatch_select(enum IsaLevel isa, kernels* out);
+
+bool dispatch_supported(enum IsaLevel isa);
+const char* dispatch_name(enum IsaLevel isa);
+
+#endif // _DISPATCH_H
@@ -0,0 +1,29 @@
+#ifndef _DYNRES_H
+#define _DYNRES_H
+
+#include<stdbool.h>
+
+// Smallest render scale the controller goes down to unless told otherwise.
+#define DYNRES_MIN_SCALE 0.5
+
+// Dynamic resolution controller.
+// Picks the scale the scene is drawn at, as a fraction of the window's width and height, so that
+// frames take no longer than a budget. Raster cost follows the pixel count, the square of the
+// scale, so the next scale comes from the square root of how far over or under budget frames are.
+// Frame times are smoothed and small corrections ignored, so it settles instead of hunting.
+typedef struct dynres_controller {
+    double scale;
+    double min_scale;
+    double budget_ms;
+    double smoothed_ms; // Recent frame times, 0 before the first one
+} dynres_controller;
+
+void dynres_init(dynres_controller* dr, double budget_ms, double min_scale);
+
+// Feeds the time the last frame took, drawn at the current scale. Returns the scale for the next one.
+double dynres_update(dynres_controller* dr, double frame_ms);
+
+// Size of the offscreen target for a window of `width` x `height` at `scale`, never 0.
+void dynres_size(double scale, int width, int height, int* out_width, int* out_height);
+
+#endif // _DYNRES_H
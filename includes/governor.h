@@ -0,0 +1,69 @@
+#ifndef _GOVERNOR_H
+#define _GOVERNOR_H
+
+#include<stdbool.h>
+
+// Frame rate the HUD is held to while GOV_HUD is shed, unless --hud-hz already asks for less.
+#define GOVERNOR_HUD_HZ 4.0
+// Cubes drawn smaller than this many window pixels across count as far while GOV_LOD is shed.
+#define GOVERNOR_LOD_PIXELS 24.0
+// Frames a moving cube waits between blends while GOV_AMORTIZE is shed.
+#define GOVERNOR_STRIDE 4
+
+// Work given up to keep frames inside the budget. Steps are shed in this order and restored in
+// reverse, each one keeps everything before it shed.
+enum GovernorStep {
+    GOV_NONE = 0,   // Everything runs every frame
+    GOV_HUD,        // The HUD refreshes at GOVERNOR_HUD_HZ at most
+    GOV_LOD,        // Far cubes are drawn as their four line outline on screen
+    GOV_AMORTIZE,   // Moving cubes take turns being blended, one in GOVERNOR_STRIDE per frame
+    GOV_STEP_COUNT
+};
+
+// Parts of a frame the governor keeps the cost of, each the one a step cuts down.
+enum GovernorStage {
+    GOV_STAGE_HUD = 0,  // Formatting and drawing the HUD
+    GOV_STAGE_LINES,    // Making, rasterizing and drawing the cubes' lines
+    GOV_STAGE_UPDATE,   // Blending cubes and rebuilding their models
+    GOV_STAGE_COUNT
+};
+
+// Frame budget governor.
+// Predicts the next frame's cost from the smoothed cost of the last ones plus how fast that has been
+// rising, and sheds the next step as soon as the prediction goes over budget. After each change
+// it waits for the smoothed costs to show its effect before deciding again.
+// What each step saves is measured as the share of its stage's cost it leaves. A step is restored
+// once the frame, with its stage scaled back up by that share, has fit well inside the budget for a
+// while, so it does not flip back and forth at the edge.
+typedef struct frame_governor {
+    int step;               // enum GovernorStep, the last one shed
+    double budget_ms;
+    double smoothed_ms;     // Recent frame costs, 0 before the first one
+    double trend_ms;        // How much smoothed_ms recently grew by per frame
+    double predicted_ms;
+    double stage_ms[GOV_STAGE_COUNT];   // Recent cost of each stage
+    double shed_ms[GOV_STEP_COUNT];     // Cost of a step's stage just before it was shed
+    double kept[GOV_STEP_COUNT];        // Share of that cost left once it was, measured after settling
+    bool measuring;         // The last change shed a step, its kept share is due once settled
+    int calm;               // Frames in a row the last step could have been restored
+    int settle;             // Frames to wait before the next change
+
+    // What was shed and for how long, for the HUD and benchmarks.
+    int sheds[GOV_STEP_COUNT];      // Times each step was shed
+    int restores[GOV_STEP_COUNT];   // Times each step was restored
+    int frames[GOV_STEP_COUNT];     // Frames drawn with each step as the last one shed
+} frame_governor;
+
+void governor_init(frame_governor* gov, double budget_ms);
+
+// Feeds the cost of the last frame and of its stages, indexed by enum GovernorStage.
+// `may_shed` false holds off shedding anything more, restoring still happens.
+// Returns the step the next frame is drawn with.
+int governor_update(frame_governor* gov, double frame_ms, const double* stage_ms, bool may_shed);
+
+// Stage a step cuts the cost of, -1 for GOV_NONE.
+int governor_step_stage(enum GovernorStep step);
+
+const char* governor_step_name(enum GovernorStep step);
+
+#endif // _GOVERNOR_H
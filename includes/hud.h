@@ -0,0 +1,36 @@
+#ifndef _HUD_H
+#define _HUD_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#define HUD_ROW_HEIGHT 30
+#define HUD_CHAR_WIDTH 10
+#define HUD_ROW_LENGTH 100
+#define HUD_MAX_ROWS 128
+
+// Retained HUD layer.
+// Rows are kept rasterized in a render target texture and only redrawn when their text changes,
+// so a frame with an unchanged HUD costs one texture copy.
+bool hud_init(SDL_Renderer* renderer, int width, int height);
+void hud_destroy();
+
+// Throttles re-formatting to `hz` refreshes per second, 0 refreshes every frame.
+void hud_set_max_hz(double hz);
+
+// Forces every row to be redrawn, needed after the renderer lost its targets.
+void hud_invalidate();
+
+// Number of rows that fit on the layer, rows past it are dropped.
+int hud_visible_rows();
+
+// Returns whether the rows should be re-formatted this frame.
+// When it does, submit rows with hud_row() and finish with hud_end().
+bool hud_begin(double now);
+void hud_row(const char* text);
+void hud_end();
+
+// Copies the layer over whatever has been drawn so far.
+void hud_composite();
+
+#endif // _HUD_H
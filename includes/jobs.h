@@ -0,0 +1,52 @@
+#ifndef _JOBS_H
+#define _JOBS_H
+
+#include<stdbool.h>
+
+#define JOBS_MAX_THREADS 64
+// Threads outside the pool that may start parallel loops, see jobs_attach().
+#define JOBS_MAX_ATTACHED 4
+// Chunks of a parallel loop are numbered in 16 bits.
+#define JOBS_MAX_CHUNKS 0xFFFF
+// Loops, spawned jobs included, that can be in flight at once. Past that they run on the calling thread.
+#define JOBS_MAX_LOOPS 16
+// jobs_chunks_for() cuts loops into at most this many chunks per thread, spare ones for stealing.
+#define JOBS_CHUNKS_PER_THREAD 8
+
+// Runs items [begin, end) of a parallel loop. `worker` is 0 for the calling thread, 1.. for pool threads.
+typedef void (*job_range_fn)(void* ctx, int begin, int end, int worker);
+
+// Starts `threads` - 1 worker threads, the thread calling jobs_parallel_for() being the last one.
+// 0 uses one thread per logical CPU. With `pin` thread k is kept on logical CPU k, where the platform allows it.
+void jobs_init(int threads, bool pin);
+void jobs_shutdown();
+
+// Threads taking part in a parallel loop, the calling one included.
+int jobs_thread_count();
+// 0 on the main thread, 1.. on pool and attached threads.
+int jobs_current_worker();
+// Lets a thread other than the main one start parallel loops, call it once from that thread after jobs_init().
+void jobs_attach();
+bool jobs_pinned();
+// Chunks taken from another thread's share since jobs_init().
+int jobs_steal_count();
+
+// Splits [0, count) into `chunks` contiguous pieces and runs them on every thread, returns once all are done.
+// Every thread starts on an even share of the chunks and steals half of another's remainder once out.
+// Chunk k always covers the same items whichever thread picks it up, so results written per chunk
+// come out the same on any thread count. May be called from inside another job.
+void jobs_parallel_for(int count, int chunks, job_range_fn fn, void* ctx);
+
+// Queues fn(ctx, 0, 1, worker) to run once on whichever thread gets to it first and returns right away.
+// Nothing waits for it, completion has to be signalled by `fn` itself.
+void jobs_spawn(job_range_fn fn, void* ctx);
+// Runs queued chunks of any loop on the calling thread, returns false when there were none to take.
+bool jobs_help();
+
+// Items [begin, end) of chunk `chunk` out of `chunks` over `count` items.
+void jobs_chunk_range(int count, int chunks, int chunk, int* begin, int* end);
+// Chunk count for a loop over `count` items not worth splitting below `grain` items a chunk.
+// 1 when the loop is small enough to run inline on the calling thread.
+int jobs_chunks_for(int count, int grain);
+
+#endif // _JOBS_H
@@ -0,0 +1,42 @@
+#ifndef _LINES_H
+#define _LINES_H
+
+#include<SDL2/SDL.h>
+
+enum LineColor {
+    LINE_FRONT = 0,
+    LINE_BACK,
+    LINE_CONNECT,
+    LINE_COLOR_COUNT
+};
+
+typedef struct line_seg {
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+} line_seg;
+
+// Frame-level line batcher.
+// Edges are collected per color over the whole frame and drawn with one SDL_RenderGeometry call
+// per color, so the number of draw calls does not depend on how many cubes there are.
+void lines_begin();
+void lines_push(enum LineColor color, float x1, float y1, float x2, float y2);
+int lines_count();
+// What was pushed for one color since lines_begin().
+const line_seg* lines_segments(enum LineColor color, int* count);
+Uint32 lines_color_argb(enum LineColor color);
+
+// Submits everything pushed since lines_begin(), returns the number of draw calls made.
+int lines_flush(SDL_Renderer* renderer);
+
+struct framebuffer;
+// Rasterizes everything pushed since lines_begin() into `fb` instead, in the same color order.
+// Makes no draw calls, raster_present() uploads the result.
+int lines_flush_soft(struct framebuffer* fb);
+
+// A one pixel wide quad through the pixel centers, stretched half a pixel past both ends
+// so it covers the same pixels SDL_RenderDrawLine would.
+void line_quad(SDL_Vertex* v, line_seg s, SDL_Color color);
+
+#endif // _LINES_H
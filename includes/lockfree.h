@@ -0,0 +1,44 @@
+#ifndef _LOCKFREE_H
+#define _LOCKFREE_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+// Lock-free handoff between exactly two threads. Neither side ever waits for the other.
+
+// Triple buffer of slot indices 0..2, the caller keeps whatever the slots refer to.
+// The writer fills its back slot and publishes it, the reader takes the most recently published one.
+// Publishing twice before the reader looks simply drops the older one.
+typedef struct triple_buffer {
+    SDL_atomic_t middle;    // Slot in between, TRIPLE_FRESH set while the reader has not taken it
+    int back;               // Writer's
+    int front;              // Reader's
+} triple_buffer;
+
+#define TRIPLE_FRESH 4
+
+void triple_init(triple_buffer* tb);
+// Writer: hands its back slot over, returns the slot to fill next.
+int triple_publish(triple_buffer* tb);
+// Reader: switches to the latest published slot if there is a new one, returns the slot to read.
+int triple_acquire(triple_buffer* tb);
+// Reader: whether something was published since the last triple_acquire(), without taking it.
+bool triple_fresh(triple_buffer* tb);
+
+// Bounded single producer, single consumer queue of fixed size items.
+typedef struct spsc_queue {
+    Uint8* items;
+    int item_size;
+    int capacity;           // Power of two
+    SDL_atomic_t head;      // Next to pop, only the consumer moves it
+    SDL_atomic_t tail;      // Next to push, only the producer moves it
+} spsc_queue;
+
+bool spsc_init(spsc_queue* q, int item_size, int capacity);
+void spsc_destroy(spsc_queue* q);
+// Producer: false when the queue is full, the item is dropped then.
+bool spsc_push(spsc_queue* q, const void* item);
+// Consumer: false when the queue is empty.
+bool spsc_pop(spsc_queue* q, void* item);
+
+#endif // _LOCKFREE_H
@@ -0,0 +1,63 @@
+#ifndef _MESH_H
+#define _MESH_H
+
+#include<SDL2/SDL.h>
+
+#include<vmath.h>
+#include<lines.h>
+#include<clip.h>
+#include<bvh.h>
+
+typedef struct mesh_edge {
+    Uint16 a;
+    Uint16 b;
+    Uint8 color;    // enum LineColor
+} mesh_edge;
+
+// Indexed wireframe: every vertex once, edges refer to them by index.
+// Vertices are in model space, the model matrix of whatever uses the mesh places them in the world.
+typedef struct wire_mesh {
+    const char* name;
+    int vertex_count;
+    const float* x;
+    const float* y;
+    const float* z;
+    float radius;   // Bounding sphere around the origin, in model space
+    float box;      // Half size of the bounding cube around the origin, in model space
+    int edge_count;
+    const mesh_edge* edges;
+} wire_mesh;
+
+// The (±1, ±1, ±1) cube, vertex c being corner c of enum CubeCorner.
+extern const wire_mesh mesh_cube;
+
+// Post-transform vertex cache.
+// Every vertex of every mesh in the pool is transformed and projected exactly once per frame,
+// vertices of cube i start at base[i] and edges index into proj_x/proj_y from there.
+// Cubes whose bounding sphere is outside the view frustum get no vertices at all.
+typedef struct vertex_cache {
+    float* world_x;
+    float* world_y;
+    float* world_z;
+    float* proj_x;
+    float* proj_y;
+    int count;
+    int capacity;
+
+    int* base;
+    Uint8* visible;     // enum CullResult per cube
+    int base_capacity;
+    int culled;
+} vertex_cache;
+
+struct cube_pool;
+
+void vcache_init(vertex_cache* cache);
+void vcache_destroy(vertex_cache* cache);
+
+// Fills the cache from the current model matrices, pool_update_models() must have run.
+// `view` culls whole cubes first, NULL keeps them all. With a `tree` built over the pool culling
+// walks it instead of testing every cube. Returns the number of vertices projected.
+int vcache_build(vertex_cache* cache, const struct cube_pool* pool, double fov, const frustum* view, const bvh* tree);
+
+#endif // _MESH_H
@@ -0,0 +1,54 @@
+#ifndef _MORTON_H
+#define _MORTON_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#include<vmath.h>
+
+#define MORTON_AXIS_BITS 10     // Per axis, 30 bit codes
+#define MORTON_CELL_SHIFT 18    // A cube moved significantly once the top 12 bits (4 levels) of its code change
+#define MORTON_DISPLACED 0x80000000u
+
+// Keeps cube storage sorted along a Z-order curve through the cube centers, so cubes that are close
+// in space are close in memory. Handles stay valid, only dense indices change.
+typedef struct morton_order {
+    // Quantization of the last sort, centers map to [0, 1023] on every axis.
+    v3 origin;
+    double cells_per_unit;
+
+    // Re-sort once more than this share of the cubes has changed cells.
+    double resort_fraction;
+    int displaced;
+    Uint32 layout_version;
+    bool sorted;
+    int sorts;
+
+    // Radix sort scratch.
+    Uint32* keys;
+    Uint32* keys_swap;
+    int* order;
+    int* order_swap;
+    int capacity;
+} morton_order;
+
+struct cube_pool;
+
+// Interleaves the low 10 bits of x, y and z, x in the lowest bit.
+Uint32 morton_encode(Uint32 x, Uint32 y, Uint32 z);
+
+void morton_init(morton_order* mo);
+void morton_destroy(morton_order* mo);
+
+// Full sort of the pool by the Morton code of every center.
+void morton_sort(morton_order* mo, struct cube_pool* pool);
+
+// Checks the cubes the last pool_update_models() touched and re-sorts when enough of them moved.
+// Returns true when the pool was reordered.
+bool morton_update(morton_order* mo, struct cube_pool* pool);
+
+// Stable LSD radix sort of `count` key/value pairs on the low `key_bits` bits, in parallel over the
+// job threads. The sorted result ends up back in `keys`/`values`.
+void radix_sort_pairs(Uint32* keys, int* values, Uint32* keys_swap, int* values_swap, int count, int key_bits);
+
+#endif // _MORTON_H
@@ -0,0 +1,58 @@
+#ifndef _PACER_H
+#define _PACER_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+// Spun through after the sleep, on top of how late SDL_Delay() has been seen waking up.
+#define PACER_SPIN_SECONDS 0.0005
+
+enum PaceMode {
+    PACE_NONE = 0,  // Frames back to back, as fast as they can be drawn
+    PACE_TIMER,     // Sleeps, then spins, up to the next frame's deadline
+    PACE_VSYNC,     // Presenting waits for the display, the renderer has to have vsync on
+    PACE_COUNT
+};
+
+// Frame pacer on the performance counter.
+// In timer mode most of the wait is an SDL_Delay(), which only promises to sleep at least as long
+// as asked. How much longer it takes is learned as it goes, and that plus a little is left to a
+// spin on the counter, so deadlines are hit precisely without burning the whole wait.
+typedef struct frame_pacer {
+    int mode;           // enum PaceMode
+    double target_hz;
+    Uint64 frequency;
+    Uint64 period;      // Counts per frame
+    Uint64 deadline;    // When the next frame is due to start
+    Uint64 frame_start;
+    double oversleep;   // Seconds SDL_Delay() recently woke up late by, at worst
+    int missed;         // Frames that took longer than the period
+
+    // The last frame, start to start, and what it was made of.
+    double frame_ms;
+    double work_ms;
+    double sleep_ms;
+    double spin_ms;
+} frame_pacer;
+
+void pacer_init(frame_pacer* pacer, enum PaceMode mode, double target_hz);
+// Switching to or from PACE_VSYNC is up to the caller to match with SDL_RenderSetVSync().
+void pacer_set_mode(frame_pacer* pacer, enum PaceMode mode);
+void pacer_set_target(frame_pacer* pacer, double target_hz);
+
+// Ends a frame. Waits until the next one is due in timer mode, returns right away otherwise.
+// A frame that ran late moves the deadlines back rather than having the next ones rush to catch up.
+void pacer_wait(frame_pacer* pacer);
+
+// Starts timing the next frame from now, for loops that sat idle since the last one.
+// Time spent idle then neither counts as a frame's work nor as a missed deadline.
+void pacer_restart(frame_pacer* pacer);
+
+// Seconds on the performance counter, for anything that used SDL_GetTicks().
+double pacer_now();
+
+const char* pace_mode_name(enum PaceMode mode);
+// -1 for unknown names.
+int pace_mode_from_name(const char* name);
+
+#endif // _PACER_H
@@ -0,0 +1,103 @@
+#ifndef _POOL_H
+#define _POOL_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#include<vmath.h>
+#include<mesh.h>
+
+#define CACHE_LINE 64
+
+// Refers to a cube independently of where it currently sits in the pool.
+// A handle goes stale once its cube is removed, even if the slot gets reused.
+typedef struct cube_handle {
+    Uint32 slot;
+    Uint32 generation;
+} cube_handle;
+
+enum CubeDirty {
+    DIRTY_MODEL = 1 << 0,       // Model matrix needs a rebuild
+    DIRTY_ROTATION = 1 << 1     // rot was set directly, rot_sin/rot_cos need recomputing
+};
+
+#define CUBE_HANDLE_NONE ((cube_handle){.slot = 0xFFFFFFFF, .generation = 0})
+
+// Growable cube storage, one contiguous array per field so hot loops only stream what they read.
+// Live cubes are kept packed in [0, count) so loops never see holes,
+// removal moves the last cube into the gap. Handles go through a slot table
+// with a free list, so adding and removing are O(1).
+typedef struct cube_pool {
+    v3* center;
+    v3* extent;     // Half size along each axis
+    v3* rot;        // Radians around x, y and z
+    v3* rot_vel;    // Radians per second added to rot while auto_rot is set
+    bool* auto_rot;
+    const wire_mesh** mesh;     // &mesh_cube unless set otherwise
+
+    // sin and cos of each rot component, kept in step with rot without trig by autorot_tick().
+    v3* rot_sin;
+    v3* rot_cos;
+    // sin and cos of rot_vel * step_dt, the per tick delta rotation of each axis.
+    v3* step_sin;
+    v3* step_cos;
+    // Rotation as a quaternion, what models are built from instead of rot_sin/rot_cos when
+    // orient_models is set. Pools mirroring the simulation blend it between snapshots.
+    quat* orient;
+
+    // translate(center) * rotate(rot) * scale(extent), rebuilt by pool_update_models().
+    m34f* model;
+    Uint8* dirty;   // enum CubeDirty bits
+    Uint32* morton; // Z-order code of the center at the last Morton sort, see morton.h
+
+    Uint32* dense_to_slot;
+    int count;
+    int capacity;
+
+    // Dense indices whose model matrix the last pool_update_models() rebuilt.
+    int* changed;
+    int changed_count;
+    // Bumped whenever cubes are added or removed, i.e. whenever dense indices may have moved.
+    Uint32 layout_version;
+    bool orient_models;
+    double step_dt; // Tick length step_sin/step_cos are for, 0 before the first autorot_tick()
+
+    // Per slot: dense index while live, next free slot while free.
+    Uint32* slot_to_dense;
+    Uint32* generations;
+    int slot_count;
+    int slot_capacity;
+    Uint32 free_head;
+} cube_pool;
+
+void pool_init(cube_pool* pool, int capacity);
+void pool_destroy(cube_pool* pool);
+
+// Appends a zeroed cube using mesh_cube and returns its handle, `out_index` receives its current dense index.
+cube_handle pool_add(cube_pool* pool, int* out_index);
+bool pool_remove(cube_pool* pool, cube_handle handle);
+void pool_clear(cube_pool* pool);
+// Moves cube order[k] to dense index k, handles keep referring to the same cubes.
+void pool_reorder(cube_pool* pool, const int* order);
+
+// Sets rot directly, trig for it is deferred to the next pool_update_models().
+static inline void pool_set_rot(cube_pool* pool, int index, v3 rot) {
+    pool->rot[index] = rot;
+    pool->dirty[index] |= DIRTY_MODEL | DIRTY_ROTATION;
+}
+
+// Recomputes rot_sin/rot_cos of a cube whose rot was set directly.
+void pool_sync_rotation(cube_pool* pool, int index);
+// Does the same for every cube flagged DIRTY_ROTATION, in one batch at trig_tier's accuracy.
+// Returns how many were synced.
+int pool_sync_rotations(cube_pool* pool);
+
+// Rebuilds the model matrix of every dirty cube, returns how many were rebuilt.
+int pool_update_models(cube_pool* pool);
+
+bool pool_valid(const cube_pool* pool, cube_handle handle);
+// -1 for stale handles.
+int pool_index(const cube_pool* pool, cube_handle handle);
+cube_handle pool_handle_at(const cube_pool* pool, int index);
+
+#endif // _POOL_H
@@ -0,0 +1,52 @@
+#ifndef _RASTER_H
+#define _RASTER_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+enum RenderBackend {
+    BACKEND_SDL = 0,    // Lines go to the renderer as geometry
+    BACKEND_SOFT,       // Lines are rasterized on the CPU and uploaded once per frame
+    BACKEND_TILED,      // Same, binned into screen tiles rasterized on every job thread
+    BACKEND_COUNT
+};
+
+// ARGB8888 pixels in memory, plus the streaming texture they are uploaded through.
+// Rows are `width` pixels apart, whatever size was allocated.
+typedef struct framebuffer {
+    Uint32* pixels;
+    int width;
+    int height;
+    int max_width;  // Allocated size, raster_resize() goes anywhere up to it
+    int max_height;
+    SDL_Texture* texture;
+} framebuffer;
+
+// `renderer` may be NULL for a framebuffer that is never presented.
+bool raster_init(framebuffer* fb, SDL_Renderer* renderer, int width, int height);
+void raster_destroy(framebuffer* fb);
+// Draws at a smaller size within the allocated one, without reallocating anything.
+void raster_resize(framebuffer* fb, int width, int height);
+
+void raster_clear(framebuffer* fb, Uint32 argb);
+// Draws the pixels of a line that fall inside `rect`, both endpoints included like SDL_RenderDrawLine.
+// A line split over several rectangles comes out exactly as if it was drawn in one go.
+// Horizontal and vertical lines are filled as spans. The SIMD variants also fill the horizontal
+// runs of shallow lines as spans, every variant draws the very same pixels.
+// Called through `kern.raster_line`, see dispatch.h.
+typedef void (*raster_line_fn)(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect);
+
+void raster_line_scalar(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect);
+void raster_line_sse2(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect);
+void raster_line_avx2(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect);
+
+// Uploads the pixels through SDL_LockTexture and copies the texture over the whole target,
+// scaled up with linear filtering when the framebuffer was resized smaller.
+// Returns the number of draw calls made.
+int raster_present(framebuffer* fb, SDL_Renderer* renderer);
+
+const char* backend_name(enum RenderBackend backend);
+// -1 for unknown names.
+int backend_from_name(const char* name);
+
+#endif // _RASTER_H
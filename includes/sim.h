@@ -0,0 +1,107 @@
+#ifndef _SIM_H
+#define _SIM_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#include<vmath.h>
+#include<pool.h>
+#include<mesh.h>
+#include<lockfree.h>
+
+// Commands queued up between simulation ticks, at most this many.
+#define SIM_QUEUE_SIZE 256
+// Ticks one pass may run to catch up after a hitch, unless sim_set_max_steps() says otherwise.
+#define SIM_MAX_STEPS 5
+
+// What the simulation has to know about input, see sim_send().
+typedef struct sim_command {
+    int type;       // Up to the command handler
+    v3 value;
+    int step;
+} sim_command;
+
+// Immutable copy of the simulated cubes as of one tick, what the renderer draws from.
+// Indices are the simulation's own dense indices, not those of any pool mirroring it.
+typedef struct scene_snapshot {
+    Uint64 serial;          // Counts published snapshots, tells a new one from one seen before
+    Uint64 tick;            // Ticks simulated before this snapshot was taken
+    double time;            // Seconds of simulated time
+    Uint64 stamp;           // Performance counter value its last tick was due at
+    double dt;              // Tick length in use, longer than asked for while overloaded
+    double dropped;         // Seconds of simulated time given up so far to keep up with real time
+    Uint32 layout_version;  // The simulation pool's, changes whenever cubes were added or removed
+    int selected;           // Dense index of the selected cube, -1 for none
+
+    int count;
+    int capacity;
+    v3* center;
+    v3* extent;
+    v3* rot;
+    v3* rot_sin;
+    v3* rot_cos;
+    const wire_mesh** mesh;
+} scene_snapshot;
+
+// Advances the simulation by `dt` seconds, one tick.
+typedef void (*sim_update_fn)(cube_pool* pool, double dt);
+// Applies one command, `selected` is the handle of the selected cube and may be changed.
+typedef void (*sim_command_fn)(cube_pool* pool, cube_handle* selected, const sim_command* cmd);
+
+// Simulation thread.
+// It owns its cube pool and ticks it at a fixed `dt` on its own, however slowly frames are drawn.
+// After a hitch it catches up by a bounded number of ticks and drops the rest of the backlog.
+// Under sustained load it lengthens the tick, up to four times `dt`, and shortens it again once
+// the load is gone.
+// Ticks that move nothing are taken to mean nothing moves until a command arrives, the thread then
+// sleeps until one does instead of ticking on.
+// After every batch of ticks that changed anything it copies the cubes into a snapshot and publishes
+// it through a triple buffer, so the renderer always finds the newest finished snapshot without
+// waiting for anything.
+// Input gets to it as commands through a single producer, single consumer queue.
+void sim_init(double dt, sim_update_fn update, sim_command_fn command);
+void sim_destroy();
+// Most ticks run back to back to catch up, before sim_start().
+void sim_set_max_steps(int steps);
+// Has an SDL event of `event_type` pushed whenever a snapshot is published, so a renderer waiting
+// for events wakes up for it. 0, the default, pushes nothing. Before sim_start().
+void sim_set_notify(Uint32 event_type);
+
+// The simulation's pool and selection, only to be touched before sim_start() or after sim_stop().
+cube_pool* sim_pool();
+cube_handle* sim_selected();
+
+// Publishes the initial snapshot and starts ticking on a thread of its own.
+void sim_start();
+void sim_stop();
+
+// Input thread: queues a command for the next tick, false if the queue was full and it got dropped.
+bool sim_send(sim_command cmd);
+
+// Render thread: the newest published snapshot. It stays valid, unchanged, until the next call.
+const scene_snapshot* sim_latest();
+// Render thread: whether there is a snapshot sim_mirror() has not seen yet.
+bool sim_fresh();
+
+// Render thread: makes a snapshot the newest state `pool` mirrors, adding or dropping cubes when
+// the layout changed. The previous snapshot's state is kept around, sim_blend() draws in between.
+// The pool may be reordered in between, its cubes are tracked by handle.
+// Returns the number of cubes that moved since the previous snapshot.
+int sim_mirror(const scene_snapshot* snap, cube_pool* pool);
+
+// How far the render clock is past the newest mirrored snapshot, as a fraction of the time between
+// it and the one before. Drawing the blend at this point trails the simulation by one step, but
+// moves as smoothly as the frame rate allows whatever the tick rate is. Clamped to [0, 1].
+double sim_alpha();
+
+// Positions and slerps the orientation of every moving cube `alpha` of the way from the previous
+// mirrored snapshot to the newest, marking only those dirty. 1 shows the newest snapshot as is.
+// Returns the number of cubes written.
+int sim_blend(cube_pool* pool, double alpha);
+
+// sim_blend() spread over `stride` frames: of the moving cubes only those whose index is `phase`
+// modulo `stride` are blended, the rest keep where they were last drawn. Cubes coming to rest are
+// all written. `owed` receives the number of moving cubes left for other phases, NULL ignores it.
+int sim_blend_part(cube_pool* pool, double alpha, int stride, int phase, int* owed);
+
+#endif // _SIM_H
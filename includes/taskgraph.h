@@ -0,0 +1,101 @@
+#ifndef _TASKGRAPH_H
+#define _TASKGRAPH_H
+
+#include<stdio.h>
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#define TGRAPH_MAX_TASKS 32
+#define TGRAPH_MAX_DEPS 4
+
+enum TaskAffinity {
+    TASK_ANY = 0,   // Runs on whichever job thread gets to it first
+    TASK_MAIN       // Touches the window or renderer, only ever runs on the main thread
+};
+
+typedef void (*task_fn)(void* ctx);
+
+// Tasks of one frame, also their ids in the graph tgraph_frame() builds.
+enum FrameTask {
+    FRAME_EVENTS = 0,   // Input, main thread
+    FRAME_SYNC,         // Takes the newest simulation snapshot
+    FRAME_MODELS,       // Blends cubes and rebuilds their models
+    FRAME_TRANSFORM,
+    FRAME_LINES,
+    FRAME_RASTER,
+    FRAME_HUD,          // Formats the HUD rows
+    FRAME_HUD_DRAW,     // Draws them into the HUD layer, main thread
+    FRAME_DRAW,         // Main thread
+    FRAME_PRESENT,      // Main thread
+    FRAME_TASK_COUNT
+};
+
+struct task_graph;
+
+typedef struct task {
+    const char* name;
+    task_fn fn;
+    void* ctx;
+    enum TaskAffinity affinity;
+    struct task_graph* graph;
+
+    int deps[TGRAPH_MAX_DEPS];
+    int dep_count;
+    int dependents[TGRAPH_MAX_TASKS];
+    int dependent_count;
+    SDL_atomic_t pending;   // Dependencies not finished yet
+
+    // Where and when it last ran, performance counter ticks.
+    int worker;
+    Uint64 start;
+    Uint64 end;
+} task;
+
+// Dependency graph of one frame's work, run on the job pool.
+// Tasks are added in an order their dependencies allow: a task can only depend on tasks added before it.
+// Each task is queued as soon as everything it depends on has finished, so independent ones run at
+// the same time, and tasks that use parallel loops of their own share the pool with whatever else runs.
+typedef struct task_graph {
+    task tasks[TGRAPH_MAX_TASKS];
+    int count;
+    SDL_atomic_t unfinished;
+
+    // Ready TASK_MAIN tasks in the order they became ready, only the main thread pops them.
+    int main_ready[TGRAPH_MAX_TASKS];
+    SDL_atomic_t main_published[TGRAPH_MAX_TASKS];
+    SDL_atomic_t main_tail;
+    int main_head;
+    SDL_sem* main_wake;
+
+    Uint64 start;
+    Uint64 end;
+} task_graph;
+
+bool tgraph_init(task_graph* graph);
+void tgraph_destroy(task_graph* graph);
+
+// Drops every task, for building the next frame's graph.
+void tgraph_reset(task_graph* graph);
+// Returns the new task's id.
+int tgraph_add(task_graph* graph, const char* name, enum TaskAffinity affinity, task_fn fn, void* ctx);
+// `task` waits for `on`, which has to have been added before it.
+void tgraph_depend(task_graph* graph, int task, int on);
+
+// Wires up a frame's tasks, one function per enum FrameTask, all given `ctx`.
+void tgraph_frame(task_graph* graph, const task_fn* fns, void* ctx);
+
+// Runs every task, returns once all are done. Main thread only.
+void tgraph_run(task_graph* graph);
+
+// Chain of dependent tasks that took longest in the last run, ids from first to last into `path`.
+// Returns the chain's length, `ms` receives its duration.
+int tgraph_critical_path(const task_graph* graph, int* path, double* ms);
+double tgraph_ms(const task_graph* graph);
+
+// Chrome trace event format, opens in chrome://tracing or Perfetto.
+// Tasks show up per thread, dependencies as flow arrows and the critical path in red.
+bool tgraph_trace_open(const char* path);
+void tgraph_trace_frame(const task_graph* graph, int frame);
+void tgraph_trace_close();
+
+#endif // _TASKGRAPH_H
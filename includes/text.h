@@ -0,0 +1,27 @@
+#ifndef _TEXT_H
+#define _TEXT_H
+
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+#include<SDL2/SDL_ttf.h>
+
+// Printable ASCII, everything else is skipped when laying out a string.
+#define TEXT_FIRST_GLYPH 32
+#define TEXT_LAST_GLYPH 126
+#define TEXT_GLYPH_COUNT (TEXT_LAST_GLYPH - TEXT_FIRST_GLYPH + 1)
+
+// Quads buffered before a flush is forced. One quad per glyph plus one per string background.
+#define TEXT_MAX_QUADS 2048
+
+bool text_init(SDL_Renderer* renderer, TTF_Font* font);
+void text_destroy();
+
+// Unscaled width of the string in font pixels.
+int text_measure(const char* text);
+
+// Queues a string stretched into the (x, y, w, h) box over a solid background.
+// Nothing reaches the renderer until text_flush().
+void text_draw(const char* text, SDL_Color fg, SDL_Color bg, int x, int y, int w, int h);
+void text_flush();
+
+#endif // _TEXT_H
@@ -0,0 +1,17 @@
+#ifndef _TILER_H
+#define _TILER_H
+
+#include<SDL2/SDL.h>
+
+#include<raster.h>
+
+#define TILE_SIZE 64
+
+// Tiled, multi-threaded counterpart of lines_flush_soft().
+// Edges pushed since lines_begin() are binned into every TILE_SIZE square tile they touch, then the
+// job threads clear and rasterize whole tiles, each owning its pixels, so the framebuffer needs no locks.
+// Within a tile edges are drawn in push order, the output is the same as the single-threaded path.
+// Returns the number of (edge, tile) pairs binned.
+int tiler_flush(framebuffer* fb, Uint32 clear_argb);
+
+#endif // _TILER_H
@@ -0,0 +1,37 @@
+#ifndef _TRIG_H
+#define _TRIG_H
+
+// Approximate sin/cos for angles that change every frame.
+// Tiers are ordered by accuracy, which one is cheapest depends on the dispatched kernels.
+enum TrigTier {
+    TRIG_TABLE = 0,     // 256 entry table, linear interpolation
+    TRIG_POLY,          // Quadrant reduction + minimax polynomials on [-pi/4, pi/4]
+    TRIG_LIBM,          // Reference
+    TRIG_TIER_COUNT
+};
+
+// Tier used for per-frame trig, TRIG_LIBM until trig_select() says otherwise.
+extern enum TrigTier trig_tier;
+
+void trig_sincos(enum TrigTier tier, double x, double* s, double* c);
+void trig_sincos_batch(enum TrigTier tier, const double* x, double* s, double* c, int count);
+
+typedef void (*sincos_batch_fn)(const double* x, double* s, double* c, int count);
+
+// Polynomial tier batch kernels, reached through the dispatch table.
+void trig_poly_batch_scalar(const double* x, double* s, double* c, int count);
+void trig_poly_batch_avx2(const double* x, double* s, double* c, int count);
+
+// Largest absolute sin/cos error of a tier, measured over a sweep of angles.
+double trig_max_error(enum TrigTier tier);
+
+// Worst case pixel displacement a sin/cos error causes on a screen of this size:
+// three chained axis rotations of a point at most a screen diagonal from its pivot.
+double trig_pixel_error(double error, int screen_width, int screen_height);
+
+// Picks the fastest tier, as timed on this machine, whose pixel error stays under `max_pixels`.
+enum TrigTier trig_select(int screen_width, int screen_height, double max_pixels);
+
+const char* trig_tier_name(enum TrigTier tier);
+
+#endif // _TRIG_H
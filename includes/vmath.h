@@ -0,0 +1,137 @@
+#ifndef _VMATH_H
+#define _VMATH_H
+
+#include<math.h>
+
+typedef struct v3 {
+    double x;
+    double y;
+    double z;
+} v3;
+
+static inline v3 v_add(v3 a, v3 b) {
+    return (v3){
+        .x = a.x + b.x,
+        .y = a.y + b.y,
+        .z = a.z + b.z
+    };
+}
+
+static inline v3 v_min(v3 a, v3 b) {
+    return (v3){
+        .x = a.x - b.x,
+        .y = a.y - b.y,
+        .z = a.z - b.z
+    };
+}
+
+// Rotations
+// NOTE: This is all unoptimized, but I don't care, I simply want to code.
+// Consider precomputing sines and cosines beforehand then multiplying respective coordinations.
+// https://en.wikipedia.org/wiki/Rotation_matrix
+static inline v3 v_rotate_x(v3 a, double angle) {
+    // [1 0          0          ][x]   [x]
+    // [0 cos(theta) -sin(theta)][y] = [y * cos(theta) - z * sin(theta)]
+    // [0 sin(theta) cos(theta) ][z] = [y * sin(theta) + z * cos(theta)]
+
+    double s = sin(angle);
+    double c = cos(angle);
+
+    return (v3){
+        .x = a.x,
+        .y = a.y * c - a.z * s,
+        .z = a.y * s + a.z * c
+    };
+}
+
+static inline v3 v_rotate_y(v3 a, double angle) {
+    // [cos(theta) 0 -sin(theta)][x]   [x * cos(theta) - z * sin(theta)]
+    // [0          1 0          ][y] = [y]
+    // [sin(theta) 0 cos(theta) ][z]   [x * sin(theta) + z * cos(theta)]
+
+    double s = sin(angle);
+    double c = cos(angle);
+
+    return (v3){
+        .x = a.x * c - a.z * s,
+        .y = a.y,
+        .z = a.x * s + a.z * c
+    };
+}
+
+static inline v3 v_rotate_z(v3 a, double angle) {
+    // [cos(theta) -sin(theta) 0][x]   [x * cos(theta) - y * sin(theta)]
+    // [sin(theta) cos(theta)  0][y] = [x * sin(theta) + y * cos(theta)]
+    // [0          0           1][z]   [z]
+
+    double s = sin(angle);
+    double c = cos(angle);
+
+    return (v3){
+        .x = a.x * c - a.y * s,
+        .y = a.x * s + a.y * c,
+        .z = a.z
+    };
+}
+
+static inline v3 v_rotate(v3 a, double rot_x, double rot_y, double rot_z) {
+    return v_rotate_z(
+        v_rotate_y(
+            v_rotate_x(a, rot_x),
+            rot_y
+        ),
+        rot_z
+    );
+}
+
+// Row major 3x3 matrix.
+typedef struct m3 {
+    double m[9];
+} m3;
+
+// Row major 4x4 matrix, affine ones keep (0, 0, 0, 1) as the last row.
+typedef struct m4 {
+    double m[16];
+} m4;
+
+// Unit quaternion, w is the scalar part.
+typedef struct quat {
+    double w;
+    double x;
+    double y;
+    double z;
+} quat;
+
+// Affine 3x4 model matrix in floats, the rows of an m4 without the constant last one.
+// This is what the transform kernels consume, 48 bytes per cube.
+typedef struct m34f {
+    float m[12];
+} m34f;
+
+m3 m3_identity();
+m3 m3_mul(m3 a, m3 b);
+v3 m3_mul_v3(m3 a, v3 v);
+m3 m3_transpose(m3 a);
+// Same rotation as v_rotate: x first, then y, then z. Six trig calls.
+m3 m3_rotation_xyz(double rot_x, double rot_y, double rot_z);
+// Same as m3_rotation_xyz from precomputed sines and cosines, no trig at all.
+m3 m3_rotation_xyz_sc(v3 s, v3 c);
+
+m4 m4_identity();
+m4 m4_mul(m4 a, m4 b);
+v3 m4_mul_point(m4 a, v3 p);
+// translation * rotation * scale
+m4 m4_affine(m3 rotation, v3 translation, v3 scale);
+m34f m4_to_m34f(m4 a);
+
+quat quat_identity();
+quat quat_axis_angle(v3 axis, double angle);
+quat quat_mul(quat a, quat b);
+quat quat_normalize(quat q);
+quat quat_conjugate(quat q);
+v3 quat_rotate(quat q, v3 v);
+m3 quat_to_m3(quat q);
+quat quat_from_m3(m3 a);
+quat quat_slerp(quat a, quat b, double t);
+
+#endif // _VMATH_H
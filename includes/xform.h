@@ -0,0 +1,57 @@
+#ifndef _XFORM_H
+#define _XFORM_H
+
+#include<vmath.h>
+
+#define CUBE_CORNERS 8
+
+// Corner c of a cube sits at center + (±x, ±y, ±z) * extent, with bit 0, 1 and 2 of c
+// selecting the + side of x, y and z. Front is -z, top is -y, so:
+enum CubeCorner {
+    CORNER_FTL = 0,
+    CORNER_FTR,
+    CORNER_FBL,
+    CORNER_FBR,
+    CORNER_BTL,
+    CORNER_BTR,
+    CORNER_BBL,
+    CORNER_BBR
+};
+
+// Takes every corner of cubes [first, first + count) through their model matrix into world space,
+// the corners being (±1, ±1, ±1) in model space. Corner c of cube i lands in out_*[(i - first) * 8 + c].
+typedef void (*xform_cubes_fn)(
+    const m34f* model,
+    int first, int count,
+    float* out_x, float* out_y, float* out_z
+);
+
+// Takes the `count` model space points of a mesh through a single model matrix into world space.
+typedef void (*xform_points_fn)(
+    const m34f* model,
+    const float* x, const float* y, const float* z,
+    int count,
+    float* out_x, float* out_y, float* out_z
+);
+
+// Perspective divide of `count` world space points onto the screen.
+typedef void (*project_fn)(
+    const float* x, const float* y, const float* z,
+    int count, double fov,
+    float* out_x, float* out_y
+);
+
+// Double precision references, also the fallback when no SIMD kernel is usable.
+void xform_cubes_scalar(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z);
+void xform_cubes_sse2(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z);
+void xform_cubes_avx2(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z);
+
+void xform_points_scalar(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z);
+void xform_points_sse2(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z);
+void xform_points_avx2(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z);
+
+void project_scalar(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y);
+void project_sse2(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y);
+void project_avx2(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y);
+
+#endif // _XFORM_H
@@ -0,0 +1,116 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<pool.h>
+#include<autorot.h>
+#include<jobs.h>
+
+// Cubes per chunk below which ticking them is not worth handing to another thread.
+#define AUTOROT_GRAIN 2048
+
+static Uint32 ticks = 0;
+
+static void set_step(cube_pool* pool, int index, double dt) {
+    v3 vel = pool->rot_vel[index];
+    pool->step_sin[index] = (v3){.x = sin(vel.x * dt), .y = sin(vel.y * dt), .z = sin(vel.z * dt)};
+    pool->step_cos[index] = (v3){.x = cos(vel.x * dt), .y = cos(vel.y * dt), .z = cos(vel.z * dt)};
+}
+
+void autorot_start(cube_pool* pool, int index, v3 vel) {
+    // The pairs are advanced from here on, so they must match rot first.
+    if (pool->dirty[index] & DIRTY_ROTATION) pool_sync_rotation(pool, index);
+
+    pool->auto_rot[index] = true;
+    pool->rot_vel[index] = vel;
+    // Before the first tick there is no tick length yet, autorot_tick() sets the steps up then.
+    if (pool->step_dt > 0.0) set_step(pool, index, pool->step_dt);
+}
+
+void autorot_stop(cube_pool* pool, int index) {
+    pool->auto_rot[index] = false;
+}
+
+// (c + is) * (step_c + i step_s)
+#define ADVANCE(axis) { \
+        double c = cs.axis * step_c.axis - sn.axis * step_s.axis; \
+        double s = sn.axis * step_c.axis + cs.axis * step_s.axis; \
+        cs.axis = c; \
+        sn.axis = s; \
+    }
+
+// First order correction towards c^2 + s^2 = 1, plenty since the error stays tiny between passes.
+#define RENORM(axis) { \
+        double k = 1.5 - 0.5 * (cs.axis * cs.axis + sn.axis * sn.axis); \
+        cs.axis *= k; \
+        sn.axis *= k; \
+    }
+
+typedef struct tick_job {
+    cube_pool* pool;
+    double dt;
+    bool renorm;
+} tick_job;
+
+// Steps of cubes [begin, end) for a new tick length.
+static void step_range(void* ctx, int begin, int end, int worker) {
+    tick_job* job = ctx;
+    for (int i = begin; i < end; i++) {
+        if (job->pool->auto_rot[i]) set_step(job->pool, i, job->dt);
+    }
+}
+
+// Cubes only ever touch their own fields, so any split of the pool gives the same result.
+static void tick_range(void* ctx, int begin, int end, int worker) {
+    tick_job* job = ctx;
+    cube_pool* pool = job->pool;
+    bool renorm = job->renorm;
+
+    for (int i = begin; i < end; i++) {
+        if (!pool->auto_rot[i]) continue;
+
+        // Edited by hand since the last tick.
+        if (pool->dirty[i] & DIRTY_ROTATION) pool_sync_rotation(pool, i);
+
+        v3 cs = pool->rot_cos[i];
+        v3 sn = pool->rot_sin[i];
+        v3 step_c = pool->step_cos[i];
+        v3 step_s = pool->step_sin[i];
+        ADVANCE(x)
+        ADVANCE(y)
+        ADVANCE(z)
+        if (renorm) {
+            RENORM(x)
+            RENORM(y)
+            RENORM(z)
+        }
+        pool->rot_cos[i] = cs;
+        pool->rot_sin[i] = sn;
+
+        // The angles themselves are only kept for display and editing.
+        v3* rot = &pool->rot[i];
+        v3 vel = pool->rot_vel[i];
+        rot->x += vel.x * job->dt;
+        rot->y += vel.y * job->dt;
+        rot->z += vel.z * job->dt;
+        while (rot->x > TAU) rot->x -= TAU;
+        while (rot->y > TAU) rot->y -= TAU;
+        while (rot->z > TAU) rot->z -= TAU;
+
+        pool->dirty[i] |= DIRTY_MODEL;
+    }
+}
+
+void autorot_tick(cube_pool* pool, double dt) {
+    tick_job job = {.pool = pool, .dt = dt, .renorm = (++ticks % AUTOROT_RENORM_TICKS) == 0};
+    int chunks = jobs_chunks_for(pool->count, AUTOROT_GRAIN);
+
+    // The tick length changed, trig once for every spinning cube and none again until the next change.
+    if (dt != pool->step_dt) {
+        jobs_parallel_for(pool->count, chunks, step_range, &job);
+        pool->step_dt = dt;
+    }
+    jobs_parallel_for(pool->count, chunks, tick_range, &job);
+}
@@ -0,0 +1,2082 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<assert.h>
+#include<malloc.h>
+#include<stddef.h>
+#include<string.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+#include<SDL2/SDL_ttf.h>
+
+#include<app.h>
+#include<text.h>
+#include<pool.h>
+#include<vmath.h>
+#include<xform.h>
+#include<dispatch.h>
+#include<autorot.h>
+#include<trig.h>
+#include<mesh.h>
+#include<clip.h>
+#include<bvh.h>
+#include<jobs.h>
+#include<morton.h>
+#include<lines.h>
+#include<raster.h>
+#include<hud.h>
+#include<tiler.h>
+#include<taskgraph.h>
+#include<sim.h>
+#include<pacer.h>
+#include<dynres.h>
+#include<governor.h>
+#include<bench.h>
+
+// Benches give auto-rotation velocities per tick, so every tick is one second long.
+#define BENCH_TICK 1.0
+
+static double now_ms() {
+    return (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// The HUD path text.c replaced: rasterize, upload and throw away every string every frame.
+static void render_text_ttf(char* text, SDL_Color fg, SDL_Color bg, int x, int y, int w, int h) {
+    SDL_Surface* surf = TTF_RenderText(app->font, text, fg, bg);
+    SDL_Texture* tex = SDL_CreateTextureFromSurface(app->renderer, surf);
+    SDL_RenderCopy(app->renderer, tex, NULL, &(SDL_Rect){.x = x, .y = y, .w = w, .h = h});
+    SDL_DestroyTexture(tex);
+    SDL_FreeSurface(surf);
+}
+
+// Draws the same rows render_infos() would for `cubes` cubes, values changing every frame.
+static void bench_text_frame(int frame, int cubes, bool atlas) {
+    char row[100];
+    SDL_Color pink = (SDL_Color){.r = 255, .g = 200, .b = 200, .a = 255};
+    SDL_Color black = (SDL_Color){.r = 0, .g = 0, .b = 0, .a = 255};
+    int rows = 3 + 7 * cubes;
+
+    SDL_SetRenderDrawColor(app->renderer, 255, 200, 200, 255);
+    SDL_RenderClear(app->renderer);
+    for (int i = 0; i < rows; i++) {
+        sprintf(row, "   - rx: %i", (frame + i) % 360);
+        int w = (int)SDL_strlen(row) * 10;
+        if (atlas) {
+            text_draw(row, black, pink, app->screen_width - w, i * 30, w, 30);
+        } else {
+            render_text_ttf(row, black, pink, app->screen_width - w, i * 30, w, 30);
+        }
+    }
+    if (atlas) text_flush();
+    SDL_RenderPresent(app->renderer);
+}
+
+static int bench_text() {
+    const int frames = 300;
+    const int cube_counts[] = {2, 10, 50};
+
+    print("%8s %8s %14s %14s %8s\n", "cubes", "rows", "ttf ms/frame", "atlas ms/frame", "speedup");
+    for (int c = 0; c < (int)(sizeof(cube_counts) / sizeof(cube_counts[0])); c++) {
+        int cubes = cube_counts[c];
+        double ms[2];
+        for (int mode = 0; mode < 2; mode++) {
+            // One warm-up frame so driver-side setup is not billed to either path.
+            bench_text_frame(0, cubes, mode == 1);
+            double start = now_ms();
+            for (int f = 0; f < frames; f++) {
+                bench_text_frame(f, cubes, mode == 1);
+            }
+            ms[mode] = (now_ms() - start) / frames;
+        }
+        print("%8d %8d %14.3f %14.3f %7.1fx\n", cubes, 3 + 7 * cubes, ms[0], ms[1], ms[0] / ms[1]);
+    }
+    return 0;
+}
+
+static Uint32 bench_rand(Uint32* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Churns a private pool: fill, remove a random half, refill, checking handles along the way.
+static int bench_pool() {
+    const int sizes[] = {100000, 1000000};
+    int failures = 0;
+
+    print("%10s %12s %12s %12s %12s\n", "cubes", "add ns", "remove ns", "re-add ns", "iterate ns");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        cube_pool pool;
+        pool_init(&pool, 16);
+        cube_handle* handles = malloc(sizeof(cube_handle) * n);
+        Uint32 seed = 1234;
+
+        double start = now_ms();
+        for (int i = 0; i < n; i++) {
+            int index;
+            handles[i] = pool_add(&pool, &index);
+            pool.rot[index].x = i;
+        }
+        double add_ms = now_ms() - start;
+
+        // Random half, duplicates just fail the second time round.
+        start = now_ms();
+        for (int i = 0; i < n / 2; i++) {
+            pool_remove(&pool, handles[bench_rand(&seed) % n]);
+        }
+        double remove_ms = now_ms() - start;
+
+        for (int i = 0; i < n; i++) {
+            int index = pool_index(&pool, handles[i]);
+            if (index >= 0 && pool.rot[index].x != i) failures++;
+        }
+
+        int removed = n - pool.count;
+        start = now_ms();
+        for (int i = 0; i < removed; i++) {
+            pool_add(&pool, NULL);
+        }
+        double readd_ms = now_ms() - start;
+
+        // Stale handles must not resolve to the cubes that reused their slots.
+        for (int i = 0; i < n; i++) {
+            int index = pool_index(&pool, handles[i]);
+            if (index >= 0 && pool.rot[index].x != i) failures++;
+        }
+        for (int i = 0; i < pool.count; i++) {
+            if (pool_index(&pool, pool_handle_at(&pool, i)) != i) failures++;
+        }
+
+        start = now_ms();
+        double sum = 0.0;
+        for (int i = 0; i < pool.count; i++) {
+            sum += pool.rot[i].x;
+        }
+        double iterate_ms = now_ms() - start;
+
+        print("%10d %12.1f %12.1f %12.1f %12.2f  (checksum %.0f)\n",
+            n,
+            add_ms * 1e6 / n,
+            remove_ms * 1e6 / (n / 2),
+            readd_ms * 1e6 / (removed > 0 ? removed : 1),
+            iterate_ms * 1e6 / pool.count,
+            sum
+        );
+
+        free(handles);
+        pool_destroy(&pool);
+    }
+
+    if (failures > 0) {
+        print("%d handle mismatches.\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+// The array-of-structs cube the pool replaced, kept here as the comparison baseline.
+typedef struct cube_aos {
+    v3 ftl, ftr, fbl, fbr;
+    v3 btl, btr, bbl, bbr;
+    v3 center;
+    double x_rot, y_rot, z_rot;
+    bool auto_rot;
+    double auto_x_rot, auto_y_rot, auto_z_rot;
+} cube_aos;
+
+typedef struct field_span {
+    size_t offset;
+    size_t size;
+} field_span;
+
+#define SPAN(type, field) {offsetof(type, field), sizeof(((type*)0)->field)}
+
+// Distinct cache lines a loop over `n` elements reading `fields` pulls in, as bytes per element.
+// Fields must be sorted by offset.
+static double bytes_touched(const void* base, size_t stride, const field_span* fields, int field_count, int n) {
+    long long lines = 0;
+    long long last = -1;
+    for (int i = 0; i < n; i++) {
+        uintptr_t element = (uintptr_t)base + stride * i;
+        for (int f = 0; f < field_count; f++) {
+            long long first_line = (long long)((element + fields[f].offset) / CACHE_LINE);
+            long long last_line = (long long)((element + fields[f].offset + fields[f].size - 1) / CACHE_LINE);
+            for (long long l = first_line; l <= last_line; l++) {
+                if (l > last) {
+                    lines++;
+                    last = l;
+                }
+            }
+        }
+    }
+    return (double)(lines * CACHE_LINE) / n;
+}
+
+static double project_sum(v3 p) {
+    double fov = app->fov;
+    return (int)(p.x * fov / (fov + p.z)) + (int)(p.y * fov / (fov + p.z));
+}
+
+// One update tick plus the corner transform and projection, old layout.
+static double frame_aos(cube_aos* cubes, int n) {
+    for (int i = 0; i < n; i++) {
+        cube_aos* cub = &cubes[i];
+        if (cub->auto_rot) {
+            cub->x_rot += cub->auto_x_rot;
+            cub->y_rot += cub->auto_y_rot;
+            cub->z_rot += cub->auto_z_rot;
+            while (cub->x_rot > 6.28) cub->x_rot -= 6.28;
+            while (cub->y_rot > 6.28) cub->y_rot -= 6.28;
+            while (cub->z_rot > 6.28) cub->z_rot -= 6.28;
+        }
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        cube_aos cub = cubes[i];
+        #define aos_corner(v) \
+            project_sum(v_add(v_rotate(v_min(v, cub.center), cub.x_rot, cub.y_rot, cub.z_rot), cub.center))
+        sum += aos_corner(cub.ftl) + aos_corner(cub.ftr) + aos_corner(cub.fbl) + aos_corner(cub.fbr);
+        sum += aos_corner(cub.btl) + aos_corner(cub.btr) + aos_corner(cub.bbl) + aos_corner(cub.bbr);
+        #undef aos_corner
+    }
+    return sum;
+}
+
+// Same work on the pool's per-field arrays.
+static double frame_soa(cube_pool* pool) {
+    int n = pool->count;
+    for (int i = 0; i < n; i++) {
+        if (pool->auto_rot[i]) {
+            v3* rot = &pool->rot[i];
+            v3 vel = pool->rot_vel[i];
+            rot->x += vel.x;
+            rot->y += vel.y;
+            rot->z += vel.z;
+            while (rot->x > 6.28) rot->x -= 6.28;
+            while (rot->y > 6.28) rot->y -= 6.28;
+            while (rot->z > 6.28) rot->z -= 6.28;
+        }
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        v3 center = pool->center[i];
+        v3 e = pool->extent[i];
+        v3 rot = pool->rot[i];
+        for (int c = 0; c < 8; c++) {
+            v3 local = (v3){
+                .x = (c & 1) ? e.x : -e.x,
+                .y = (c & 2) ? e.y : -e.y,
+                .z = (c & 4) ? e.z : -e.z
+            };
+            sum += project_sum(v_add(v_rotate(local, rot.x, rot.y, rot.z), center));
+        }
+    }
+    return sum;
+}
+
+static int bench_layout() {
+    const int n = 100000;
+    const int frames = 20;
+
+    cube_aos* aos = malloc(sizeof(cube_aos) * n);
+    cube_pool pool;
+    pool_init(&pool, n);
+
+    for (int i = 0; i < n; i++) {
+        double x = (i % 40) * 30.0;
+        double y = ((i / 40) % 30) * 30.0;
+        double z = (i / 1200) * 30.0;
+        double size = 20.0;
+        double spin = (i % 3) * 0.01;
+
+        cube_aos* a = &aos[i];
+        a->ftl = (v3){x, y, z};
+        a->ftr = (v3){x + size, y, z};
+        a->fbl = (v3){x, y + size, z};
+        a->fbr = (v3){x + size, y + size, z};
+        a->btl = (v3){x, y, z + size};
+        a->btr = (v3){x + size, y, z + size};
+        a->bbl = (v3){x, y + size, z + size};
+        a->bbr = (v3){x + size, y + size, z + size};
+        a->center = (v3){x + size / 2, y + size / 2, z + size / 2};
+        a->x_rot = a->y_rot = a->z_rot = 0.0;
+        a->auto_rot = true;
+        a->auto_x_rot = spin;
+        a->auto_y_rot = spin * 2;
+        a->auto_z_rot = spin * 3;
+
+        int index;
+        pool_add(&pool, &index);
+        pool.center[index] = a->center;
+        pool.extent[index] = (v3){size / 2, size / 2, size / 2};
+        pool.rot[index] = (v3){0.0, 0.0, 0.0};
+        pool.rot_vel[index] = (v3){spin, spin * 2, spin * 3};
+        pool.auto_rot[index] = true;
+    }
+
+    const field_span aos_update[] = {
+        SPAN(cube_aos, x_rot), SPAN(cube_aos, y_rot), SPAN(cube_aos, z_rot),
+        SPAN(cube_aos, auto_rot),
+        SPAN(cube_aos, auto_x_rot), SPAN(cube_aos, auto_y_rot), SPAN(cube_aos, auto_z_rot)
+    };
+    const field_span aos_transform[] = {
+        SPAN(cube_aos, ftl), SPAN(cube_aos, ftr), SPAN(cube_aos, fbl), SPAN(cube_aos, fbr),
+        SPAN(cube_aos, btl), SPAN(cube_aos, btr), SPAN(cube_aos, bbl), SPAN(cube_aos, bbr),
+        SPAN(cube_aos, center), SPAN(cube_aos, x_rot), SPAN(cube_aos, y_rot), SPAN(cube_aos, z_rot)
+    };
+    const field_span whole_v3 = {0, sizeof(v3)};
+    const field_span whole_bool = {0, sizeof(bool)};
+
+    double aos_update_bytes = bytes_touched(aos, sizeof(cube_aos), aos_update, 7, n);
+    double aos_transform_bytes = bytes_touched(aos, sizeof(cube_aos), aos_transform, 12, n);
+    double soa_update_bytes =
+        bytes_touched(pool.auto_rot, sizeof(bool), &whole_bool, 1, n) +
+        bytes_touched(pool.rot, sizeof(v3), &whole_v3, 1, n) +
+        bytes_touched(pool.rot_vel, sizeof(v3), &whole_v3, 1, n);
+    double soa_transform_bytes =
+        bytes_touched(pool.center, sizeof(v3), &whole_v3, 1, n) +
+        bytes_touched(pool.extent, sizeof(v3), &whole_v3, 1, n) +
+        bytes_touched(pool.rot, sizeof(v3), &whole_v3, 1, n);
+
+    double checksum[2] = {0.0, 0.0};
+    double ms[2];
+    for (int layout = 0; layout < 2; layout++) {
+        double start = now_ms();
+        for (int f = 0; f < frames; f++) {
+            checksum[layout] += (layout == 0) ? frame_aos(aos, n) : frame_soa(&pool);
+        }
+        ms[layout] = (now_ms() - start) / frames;
+    }
+
+    print("%d cubes, %d frames of update + transform + projection\n", n, frames);
+    print("%6s %12s %14s %17s %14s\n", "layout", "cube bytes", "update B/cube", "transform B/cube", "ms/frame");
+    print("%6s %12d %14.1f %17.1f %14.3f\n", "AoS", (int)sizeof(cube_aos), aos_update_bytes, aos_transform_bytes, ms[0]);
+    print("%6s %12d %14.1f %17.1f %14.3f\n", "SoA",
+        (int)(sizeof(v3) * 4 + sizeof(bool)), soa_update_bytes, soa_transform_bytes, ms[1]);
+    print("checksums %.0f / %.0f\n", checksum[0], checksum[1]);
+
+    free(aos);
+    pool_destroy(&pool);
+    return 0;
+}
+
+// Random scene for the transform kernels, kept in front of the eye so projections stay finite.
+static void fill_random_scene(cube_pool* pool, int n, Uint32 seed) {
+    for (int i = 0; i < n; i++) {
+        int index;
+        pool_add(pool, &index);
+        pool->center[index] = (v3){
+            .x = (bench_rand(&seed) % 1600) - 400.0,
+            .y = (bench_rand(&seed) % 1200) - 300.0,
+            .z = (bench_rand(&seed) % 2000)
+        };
+        double size = 5.0 + bench_rand(&seed) % 100;
+        pool->extent[index] = (v3){size / 2, size / 2, size / 4};
+        pool->rot[index] = (v3){
+            .x = (bench_rand(&seed) % 6283) / 1000.0,
+            .y = (bench_rand(&seed) % 6283) / 1000.0,
+            .z = (bench_rand(&seed) % 6283) / 1000.0
+        };
+    }
+}
+
+// Largest pixel distance between a kernel's corners and the per-vertex v_rotate path.
+static double xform_error(const cube_pool* pool, const float* xs, const float* ys) {
+    double worst = 0.0;
+    double fov = app->fov;
+    for (int i = 0; i < pool->count; i++) {
+        v3 e = pool->extent[i];
+        v3 r = pool->rot[i];
+        for (int k = 0; k < CUBE_CORNERS; k++) {
+            v3 local = (v3){
+                .x = (k & 1) ? e.x : -e.x,
+                .y = (k & 2) ? e.y : -e.y,
+                .z = (k & 4) ? e.z : -e.z
+            };
+            v3 p = v_add(v_rotate(local, r.x, r.y, r.z), pool->center[i]);
+            double dx = fabs(xs[i * CUBE_CORNERS + k] - p.x * fov / (fov + p.z));
+            double dy = fabs(ys[i * CUBE_CORNERS + k] - p.y * fov / (fov + p.z));
+            if (dx > worst) worst = dx;
+            if (dy > worst) worst = dy;
+        }
+    }
+    return worst;
+}
+
+// Kernel throughput and accuracy. Fails when any kernel strays more than XFORM_MAX_ERROR pixels.
+#define XFORM_MAX_ERROR 0.01
+
+static int bench_xform() {
+    const int n = 100000;
+    const int frames = 20;
+
+    cube_pool pool;
+    pool_init(&pool, n);
+    fill_random_scene(&pool, n, 42);
+    pool_update_models(&pool);
+    size_t size = sizeof(float) * CUBE_CORNERS * n;
+    float* wx = SDL_SIMDAlloc(size);
+    float* wy = SDL_SIMDAlloc(size);
+    float* wz = SDL_SIMDAlloc(size);
+    float* xs = SDL_SIMDAlloc(size);
+    float* ys = SDL_SIMDAlloc(size);
+
+    // Baseline: what render_cube used to do, three trig pairs per corner.
+    double start = now_ms();
+    double sink = 0.0;
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < n; i++) {
+            v3 e = pool.extent[i];
+            v3 r = pool.rot[i];
+            for (int k = 0; k < CUBE_CORNERS; k++) {
+                v3 local = (v3){(k & 1) ? e.x : -e.x, (k & 2) ? e.y : -e.y, (k & 4) ? e.z : -e.z};
+                v3 p = v_add(v_rotate(local, r.x, r.y, r.z), pool.center[i]);
+                sink += p.x * app->fov / (app->fov + p.z);
+            }
+        }
+    }
+    double legacy_ms = (now_ms() - start) / frames;
+
+    int failures = 0;
+    print("%d cubes, %d frames (checksum %.0f)\n", n, frames, sink);
+    print("%8s %12s %12s %12s %14s\n", "kernels", "xform ms", "project ms", "ns/cube", "max err (px)");
+    print("%8s %12.3f %12s %12.1f %14s\n", "v_rotate", legacy_ms, "-", legacy_ms * 1e6 / n, "-");
+    for (int isa = 0; isa < ISA_COUNT; isa++) {
+        kernels k;
+        if (!dispatch_select(isa, &k)) {
+            print("%8s %12s\n", dispatch_name(isa), "unsupported");
+            continue;
+        }
+
+        start = now_ms();
+        for (int f = 0; f < frames; f++) {
+            k.xform_cubes(pool.model, 0, n, wx, wy, wz);
+        }
+        double xform_ms = (now_ms() - start) / frames;
+        start = now_ms();
+        for (int f = 0; f < frames; f++) {
+            k.project(wx, wy, wz, n * CUBE_CORNERS, app->fov, xs, ys);
+        }
+        double project_ms = (now_ms() - start) / frames;
+
+        double err = xform_error(&pool, xs, ys);
+        if (err > XFORM_MAX_ERROR) failures++;
+        print("%8s %12.3f %12.3f %12.1f %14.6f%s\n",
+            k.name, xform_ms, project_ms, (xform_ms + project_ms) * 1e6 / n, err,
+            (err > XFORM_MAX_ERROR) ? "  FAIL" : "");
+    }
+
+    SDL_SIMDFree(wx);
+    SDL_SIMDFree(wy);
+    SDL_SIMDFree(wz);
+    SDL_SIMDFree(xs);
+    SDL_SIMDFree(ys);
+    pool_destroy(&pool);
+    return (failures > 0) ? 1 : 0;
+}
+
+static long long trig_calls = 0;
+
+// Not inlined, or the compiler merges the repeated sin/cos of the same angle and hides the cost.
+__attribute__((noinline))
+static double counted_sin(double a) {
+    trig_calls++;
+    return sin(a);
+}
+
+__attribute__((noinline))
+static double counted_cos(double a) {
+    trig_calls++;
+    return cos(a);
+}
+
+// v_rotate with every trig call counted, the per-vertex path render_cube used to take.
+static v3 counted_rotate(v3 a, v3 r) {
+    double s = counted_sin(r.x), c = counted_cos(r.x);
+    a = (v3){a.x, a.y * c - a.z * s, a.y * s + a.z * c};
+    s = counted_sin(r.y), c = counted_cos(r.y);
+    a = (v3){a.x * c - a.z * s, a.y, a.x * s + a.z * c};
+    s = counted_sin(r.z), c = counted_cos(r.z);
+    return (v3){a.x * c - a.y * s, a.x * s + a.y * c, a.z};
+}
+
+// Per-vertex rotation against cached model matrices, for a static scene and one where every cube spins.
+static int bench_model() {
+    const int n = 100000;
+    const int frames = 20;
+
+    cube_pool pool;
+    pool_init(&pool, n);
+    fill_random_scene(&pool, n, 7);
+    size_t size = sizeof(float) * CUBE_CORNERS * n;
+    float* wx = SDL_SIMDAlloc(size);
+    float* wy = SDL_SIMDAlloc(size);
+    float* wz = SDL_SIMDAlloc(size);
+
+    print("%d cubes, %d frames, %s kernels\n", n, frames, kern.name);
+    print("%10s %10s %12s %12s\n", "scene", "path", "trig/cube", "ns/cube");
+    for (int spinning = 0; spinning < 2; spinning++) {
+        const char* scene_name = spinning ? "spinning" : "static";
+
+        trig_calls = 0;
+        double sink = 0.0;
+        double start = now_ms();
+        for (int f = 0; f < frames; f++) {
+            for (int i = 0; i < n; i++) {
+                if (spinning) pool.rot[i].x += 0.01;
+                v3 e = pool.extent[i];
+                for (int k = 0; k < CUBE_CORNERS; k++) {
+                    v3 local = (v3){(k & 1) ? e.x : -e.x, (k & 2) ? e.y : -e.y, (k & 4) ? e.z : -e.z};
+                    sink += v_add(counted_rotate(local, pool.rot[i]), pool.center[i]).z;
+                }
+            }
+        }
+        double ms = (now_ms() - start) / frames;
+        print("%10s %10s %12.2f %12.1f\n", scene_name, "v_rotate", (double)trig_calls / frames / n, ms * 1e6 / n);
+
+        long long rebuilt = 0;
+        pool_update_models(&pool);
+        start = now_ms();
+        for (int f = 0; f < frames; f++) {
+            if (spinning) {
+                for (int i = 0; i < n; i++) {
+                    v3 rot = pool.rot[i];
+                    rot.x += 0.01;
+                    pool_set_rot(&pool, i, rot);
+                }
+            }
+            rebuilt += pool_update_models(&pool);
+            kern.xform_cubes(pool.model, 0, n, wx, wy, wz);
+            sink += wz[f];
+        }
+        ms = (now_ms() - start) / frames;
+        // m3_rotation_xyz is the only trig on this path, six calls per rebuilt model.
+        print("%10s %10s %12.2f %12.1f  (checksum %.0f)\n", scene_name, "model", 6.0 * rebuilt / frames / n, ms * 1e6 / n, sink);
+    }
+
+    // Same spin driven by the auto-rotation engine, sin/cos advance without trig.
+    for (int i = 0; i < n; i++) {
+        autorot_start(&pool, i, (v3){.x = 0.01, .y = 0.0, .z = 0.0});
+    }
+    pool_update_models(&pool);
+    double start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        autorot_tick(&pool, BENCH_TICK);
+        pool_update_models(&pool);
+        kern.xform_cubes(pool.model, 0, n, wx, wy, wz);
+    }
+    double ms = (now_ms() - start) / frames;
+    print("%10s %10s %12.2f %12.1f\n", "spinning", "autorot", 0.0, ms * 1e6 / n);
+
+    SDL_SIMDFree(wx);
+    SDL_SIMDFree(wy);
+    SDL_SIMDFree(wz);
+    pool_destroy(&pool);
+    return 0;
+}
+
+// Runs the auto-rotation engine for 10^7 ticks and compares its sin/cos pairs with the analytic angle.
+#define DRIFT_TICKS 10000000
+#define DRIFT_MAX_ERROR 1e-9
+
+static int bench_drift() {
+    const v3 start_rot = (v3){.x = 0.3, .y = -1.2, .z = 2.5};
+    const v3 vel = (v3){.x = 0.0123, .y = -0.0456, .z = 0.0789};
+
+    cube_pool pool;
+    pool_init(&pool, 1);
+    int index;
+    pool_add(&pool, &index);
+    pool_set_rot(&pool, index, start_rot);
+    autorot_start(&pool, index, vel);
+
+    double worst = 0.0;
+    double worst_norm = 0.0;
+    double start = now_ms();
+    for (long n = 1; n <= DRIFT_TICKS; n++) {
+        autorot_tick(&pool, BENCH_TICK);
+        if (n % 1000 != 0 && n != DRIFT_TICKS) continue;
+
+        const double* sn = &pool.rot_sin[index].x;
+        const double* cs = &pool.rot_cos[index].x;
+        const double* r0 = &start_rot.x;
+        const double* v = &vel.x;
+        for (int axis = 0; axis < 3; axis++) {
+            double angle = r0[axis] + (double)n * v[axis];
+            double err = fmax(fabs(sn[axis] - sin(angle)), fabs(cs[axis] - cos(angle)));
+            double norm = fabs(sn[axis] * sn[axis] + cs[axis] * cs[axis] - 1.0);
+            if (err > worst) worst = err;
+            if (norm > worst_norm) worst_norm = norm;
+        }
+    }
+    double ms = now_ms() - start;
+
+    print("%d ticks in %.1f ms\n", DRIFT_TICKS, ms);
+    print("max |sin/cos - analytic|: %.3e\n", worst);
+    print("max |s^2 + c^2 - 1|: %.3e\n", worst_norm);
+    pool_destroy(&pool);
+
+    if (worst > DRIFT_MAX_ERROR) {
+        print("Drift above %.0e.\n", DRIFT_MAX_ERROR);
+        return 1;
+    }
+    return 0;
+}
+
+// Accuracy and throughput of every trig tier against libm, plus which one the renderer would pick.
+static int bench_sincos() {
+    const int n = 1000000;
+    const int rounds = 10;
+    double* x = malloc(sizeof(double) * n);
+    double* sn = malloc(sizeof(double) * n);
+    double* cs = malloc(sizeof(double) * n);
+
+    Uint32 seed = 99;
+    for (int i = 0; i < n; i++) {
+        x[i] = ((double)bench_rand(&seed) / (1 << 24) - 0.5) * 8 * M_PI;
+    }
+
+    print("%d angles in [-4pi, 4pi], %dx%d screen\n", n, app->screen_width, app->screen_height);
+    print("%8s %12s %14s %12s %12s\n", "tier", "max abs err", "max ulp (f32)", "max px err", "ns/value");
+    for (int tier = 0; tier < TRIG_TIER_COUNT; tier++) {
+        double start = now_ms();
+        for (int r = 0; r < rounds; r++) {
+            trig_sincos_batch(tier, x, sn, cs, n);
+        }
+        double ns = (now_ms() - start) * 1e6 / rounds / n;
+
+        double worst = 0.0;
+        double worst_ulp = 0.0;
+        for (int i = 0; i < n; i++) {
+            double rs = sin(x[i]);
+            double rc = cos(x[i]);
+            double es = fabs(sn[i] - rs);
+            double ec = fabs(cs[i] - rc);
+            worst = fmax(worst, fmax(es, ec));
+
+            float fs = fabsf((float)rs);
+            float fc = fabsf((float)rc);
+            worst_ulp = fmax(worst_ulp, es / (nextafterf(fs, INFINITY) - fs));
+            worst_ulp = fmax(worst_ulp, ec / (nextafterf(fc, INFINITY) - fc));
+        }
+
+        print("%8s %12.3e %14.1f %12.4f %12.2f%s\n",
+            trig_tier_name(tier), worst, worst_ulp,
+            trig_pixel_error(worst, app->screen_width, app->screen_height), ns,
+            (tier == TRIG_POLY) ? (kern.isa >= ISA_AVX2 ? "  (avx2)" : "  (scalar)") : "");
+    }
+
+    enum TrigTier picked = trig_select(app->screen_width, app->screen_height, 0.5);
+    print("Renderer picks %s for a 0.5 px budget.\n", trig_tier_name(picked));
+
+    free(x);
+    free(sn);
+    free(cs);
+    return 0;
+}
+
+// Vertex cache for the cube fast path against the same cube fed through the generic mesh path.
+// Fails when the two disagree by more than XFORM_MAX_ERROR pixels.
+static int bench_mesh() {
+    const int n = 100000;
+    const int frames = 20;
+
+    // Same vertices and edges as mesh_cube, but a different pointer, so it takes the generic path.
+    wire_mesh generic = mesh_cube;
+    generic.name = "generic cube";
+
+    cube_pool pool;
+    pool_init(&pool, n);
+    fill_random_scene(&pool, n, 42);
+    pool_update_models(&pool);
+
+    vertex_cache fast;
+    vertex_cache slow;
+    vcache_init(&fast);
+    vcache_init(&slow);
+
+    // What connect_lines used to cost: both endpoints of every edge were projected.
+    print("%d cubes, %d frames\n", n, frames);
+    print("Projections per cube: %d per edge endpoint, %d through the cache\n",
+        mesh_cube.edge_count * 2, mesh_cube.vertex_count);
+
+    double start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        vcache_build(&fast, &pool, app->fov, NULL, NULL);
+    }
+    double fast_ms = (now_ms() - start) / frames;
+
+    for (int i = 0; i < pool.count; i++) {
+        pool.mesh[i] = &generic;
+    }
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        vcache_build(&slow, &pool, app->fov, NULL, NULL);
+    }
+    double slow_ms = (now_ms() - start) / frames;
+
+    double worst = 0.0;
+    for (int v = 0; v < fast.count; v++) {
+        worst = fmax(worst, fabs(fast.proj_x[v] - slow.proj_x[v]));
+        worst = fmax(worst, fabs(fast.proj_y[v] - slow.proj_y[v]));
+    }
+
+    print("%14s %12s %12s\n", "path", "ms", "ns/cube");
+    print("%14s %12.3f %12.1f\n", "cube batch", fast_ms, fast_ms * 1e6 / n);
+    print("%14s %12.3f %12.1f\n", "generic mesh", slow_ms, slow_ms * 1e6 / n);
+    print("Max difference: %.6f px%s\n", worst, (worst > XFORM_MAX_ERROR) ? "  FAIL" : "");
+
+    vcache_destroy(&fast);
+    vcache_destroy(&slow);
+    pool_destroy(&pool);
+    return (worst > XFORM_MAX_ERROR) ? 1 : 0;
+}
+
+// Clips the edges of every visible cube, returns how many survive and whether any landed off screen.
+static int clip_scene(const cube_pool* pool, const vertex_cache* cache, const frustum* view, bool force_clip, int* off_screen) {
+    int kept = 0;
+    for (int i = 0; i < pool->count; i++) {
+        enum CullResult cull = cache->visible[i];
+        if (cull == CULL_OUTSIDE) continue;
+
+        const wire_mesh* mesh = pool->mesh[i];
+        int base = cache->base[i];
+        for (int e = 0; e < mesh->edge_count; e++) {
+            int a = base + mesh->edges[e].a;
+            int b = base + mesh->edges[e].b;
+            line_seg seg = {cache->proj_x[a], cache->proj_y[a], cache->proj_x[b], cache->proj_y[b]};
+            if (cull == CULL_INTERSECT || force_clip) {
+                v3 wa = {cache->world_x[a], cache->world_y[a], cache->world_z[a]};
+                v3 wb = {cache->world_x[b], cache->world_y[b], cache->world_z[b]};
+                if (clip_edge(view, wa, wb, seg.x1, seg.y1, seg.x2, seg.y2, &seg) == CLIP_REJECTED) continue;
+            }
+
+            bool inside = seg.x1 >= 0 && seg.x1 <= view->width - 1 && seg.y1 >= 0 && seg.y1 <= view->height - 1
+                && seg.x2 >= 0 && seg.x2 <= view->width - 1 && seg.y2 >= 0 && seg.y2 <= view->height - 1;
+            if (!inside) (*off_screen)++;
+            kept++;
+        }
+    }
+    return kept;
+}
+
+// Culling and clipping on a scene that spills past every screen edge and behind the eye.
+// Fails when a culled cube had a visible edge, or when anything reaches the batcher off screen.
+static int bench_clip() {
+    const int n = 100000;
+    const int frames = 20;
+
+    cube_pool pool;
+    pool_init(&pool, n);
+    fill_random_scene(&pool, n, 7);
+    for (int i = 0; i < n; i += 3) {
+        pool.center[i].z -= 2100.0;
+    }
+    pool_update_models(&pool);
+    frustum view = frustum_make(app->fov, app->screen_width, app->screen_height);
+
+    vertex_cache all;
+    vertex_cache culled;
+    vcache_init(&all);
+    vcache_init(&culled);
+
+    double start = now_ms();
+    int off_all = 0;
+    int kept_all = 0;
+    for (int f = 0; f < frames; f++) {
+        vcache_build(&all, &pool, app->fov, NULL, NULL);
+        kept_all = clip_scene(&pool, &all, &view, true, &off_all);
+    }
+    double all_ms = (now_ms() - start) / frames;
+
+    start = now_ms();
+    int off_culled = 0;
+    int kept_culled = 0;
+    for (int f = 0; f < frames; f++) {
+        vcache_build(&culled, &pool, app->fov, &view, NULL);
+        kept_culled = clip_scene(&pool, &culled, &view, false, &off_culled);
+    }
+    double culled_ms = (now_ms() - start) / frames;
+
+    int inside = 0;
+    for (int i = 0; i < n; i++) {
+        if (culled.visible[i] == CULL_INSIDE) inside++;
+    }
+
+    print("%d cubes, %d frames, a third of them around or behind the eye\n", n, frames);
+    print("Culled %d cubes, %d entirely inside, %d intersecting\n", culled.culled, inside, n - culled.culled - inside);
+    print("%14s %12s %12s %12s\n", "path", "ms", "vertices", "edges kept");
+    print("%14s %12.3f %12d %12d\n", "clip only", all_ms, all.count, kept_all);
+    print("%14s %12.3f %12d %12d\n", "cull + clip", culled_ms, culled.count, kept_culled);
+
+    int failures = 0;
+    if (kept_all != kept_culled) {
+        print("Culling dropped %d visible edges.  FAIL\n", kept_all - kept_culled);
+        failures++;
+    }
+    if (off_all + off_culled > 0) {
+        print("%d edges left the screen.  FAIL\n", (off_all + off_culled) / frames);
+        failures++;
+    }
+
+    vcache_destroy(&all);
+    vcache_destroy(&culled);
+    pool_destroy(&pool);
+    return (failures > 0) ? 1 : 0;
+}
+
+// Linear reference for bvh_cull(), every cube box against the frustum.
+static int cull_linear(const bvh* tree, const frustum* view, Uint8* visible) {
+    int culled = 0;
+    for (int i = 0; i < tree->cube_count; i++) {
+        visible[i] = (Uint8)frustum_test_aabb(view, tree->boxes[i].min, tree->boxes[i].max);
+        if (visible[i] == CULL_OUTSIDE) culled++;
+    }
+    return culled;
+}
+
+// Build, refit and query cost of the cube BVH, with queries checked against the linear scan.
+static int bench_bvh() {
+    const int sizes[] = {10000, 100000, 1000000};
+    const int rounds = 10;
+    frustum view = frustum_make(app->fov, app->screen_width, app->screen_height);
+    int failures = 0;
+
+    print("%8s %10s %12s %12s %12s %12s %12s %10s\n",
+        "cubes", "build ms", "refit 1%", "refit 100%", "nodes 1%", "query ms", "linear ms", "culled");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        cube_pool pool;
+        pool_init(&pool, n);
+        fill_random_scene(&pool, n, 1234);
+        // Spread the scene well past the screen so there are whole regions to reject.
+        for (int i = 0; i < n; i++) {
+            pool.center[i].x = (pool.center[i].x - 400.0) * 6.0 + 400.0;
+            pool.center[i].y = (pool.center[i].y - 300.0) * 6.0 + 300.0;
+            pool.center[i].z *= 2.0;
+        }
+        pool_update_models(&pool);
+
+        bvh tree;
+        bvh_init(&tree);
+        double start = now_ms();
+        for (int r = 0; r < rounds; r++) {
+            bvh_build(&tree, &pool);
+        }
+        double build_ms = (now_ms() - start) / rounds;
+
+        // Refits after rotating 1% and then all of the cubes, timed on their own.
+        Uint32 seed = 77;
+        double refit_ms[2] = {0, 0};
+        int refit_nodes = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            int step = (pass == 0) ? 100 : 1;
+            for (int r = 0; r < rounds; r++) {
+                for (int i = 0; i < n; i += step) {
+                    pool_set_rot(&pool, i, (v3){
+                        .x = (bench_rand(&seed) % 6283) / 1000.0,
+                        .y = (bench_rand(&seed) % 6283) / 1000.0,
+                        .z = (bench_rand(&seed) % 6283) / 1000.0
+                    });
+                }
+                pool_update_models(&pool);
+                start = now_ms();
+                int refit = bvh_refit(&tree, &pool);
+                refit_ms[pass] += now_ms() - start;
+                if (pass == 0) refit_nodes = refit;
+            }
+            refit_ms[pass] /= rounds;
+        }
+
+        Uint8* visible = malloc(n);
+        Uint8* expected = malloc(n);
+        start = now_ms();
+        int culled = 0;
+        for (int r = 0; r < rounds; r++) {
+            culled = bvh_cull(&tree, &view, visible);
+        }
+        double query_ms = (now_ms() - start) / rounds;
+        start = now_ms();
+        int culled_linear = 0;
+        for (int r = 0; r < rounds; r++) {
+            culled_linear = cull_linear(&tree, &view, expected);
+        }
+        double linear_ms = (now_ms() - start) / rounds;
+
+        // The refit tree has to agree with the linear scan over the current boxes.
+        int mismatches = 0;
+        for (int i = 0; i < n; i++) {
+            if ((visible[i] == CULL_OUTSIDE) != (expected[i] == CULL_OUTSIDE)) mismatches++;
+        }
+
+        print("%8d %10.3f %12.3f %12.3f %12d %12.3f %12.3f %10d%s\n",
+            n, build_ms, refit_ms[0], refit_ms[1], refit_nodes, query_ms, linear_ms, culled,
+            (mismatches > 0 || culled != culled_linear) ? "  FAIL" : "");
+        if (mismatches > 0 || culled != culled_linear) failures++;
+
+        free(visible);
+        free(expected);
+        bvh_destroy(&tree);
+        pool_destroy(&pool);
+    }
+    return (failures > 0) ? 1 : 0;
+}
+
+// Hardware miss counters are out of SDL's reach, so misses are counted on a simulated
+// 32 KiB, 8-way, 64 byte line LRU cache fed with the addresses a pass touches.
+#define SIM_WAYS 8
+#define SIM_SETS 64
+
+typedef struct sim_cache {
+    uintptr_t tags[SIM_SETS][SIM_WAYS];
+    Uint32 used[SIM_SETS][SIM_WAYS];
+    Uint32 clock;
+    long long accesses;
+    long long misses;
+} sim_cache;
+
+static void sim_touch(sim_cache* c, const void* address) {
+    uintptr_t line = (uintptr_t)address / CACHE_LINE;
+    int set = (int)(line % SIM_SETS);
+    c->accesses++;
+    c->clock++;
+
+    int victim = 0;
+    for (int w = 0; w < SIM_WAYS; w++) {
+        if (c->used[set][w] != 0 && c->tags[set][w] == line) {
+            c->used[set][w] = c->clock;
+            return;
+        }
+        if (c->used[set][w] < c->used[set][victim]) victim = w;
+    }
+    c->misses++;
+    c->tags[set][victim] = line;
+    c->used[set][victim] = c->clock;
+}
+
+// Touches the per-cube data a spatial pass reads, in BVH leaf order, i.e. neighbors after neighbors.
+static double spatial_miss_rate(const bvh* tree, const cube_pool* pool) {
+    sim_cache* c = calloc(1, sizeof(sim_cache));
+    for (int node = 0; node < tree->node_count; node++) {
+        const bvh_node* n = &tree->nodes[node];
+        for (int i = 0; i < n->count; i++) {
+            int cube = tree->items[n->first + i];
+            sim_touch(c, &pool->center[cube]);
+            sim_touch(c, &pool->model[cube]);
+            sim_touch(c, &tree->boxes[cube]);
+        }
+    }
+    double rate = (double)c->misses / (double)c->accesses;
+    free(c);
+    return rate;
+}
+
+// One frame of the scene path: refit after every cube rotated, cull through the tree, transform and clip.
+static double morton_frame(cube_pool* pool, bvh* tree, vertex_cache* cache, const frustum* view, int frames) {
+    double start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < pool->count; i++) {
+            pool->rot[i].y += 0.01;
+            pool_set_rot(pool, i, pool->rot[i]);
+        }
+        pool_update_models(pool);
+        bvh_update(tree, pool);
+        vcache_build(cache, pool, app->fov, view, tree);
+        int off_screen = 0;
+        clip_scene(pool, cache, view, false, &off_screen);
+    }
+    return (now_ms() - start) / frames;
+}
+
+// Scene order against Z-order: sort cost, simulated cache misses of a spatial pass, frame time.
+// Also checks every handle still finds its cube after the reorder.
+static int bench_morton() {
+    const int sizes[] = {100000, 1000000};
+    const int frames = 10;
+    frustum view = frustum_make(app->fov, app->screen_width, app->screen_height);
+    int failures = 0;
+
+    print("%d job thread(s)\n", jobs_thread_count());
+    print("%8s %10s %10s %12s %12s %12s\n", "cubes", "order", "sort ms", "miss rate", "frame ms", "handles ok");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        cube_pool pool;
+        pool_init(&pool, n);
+        fill_random_scene(&pool, n, 4321);
+        pool_update_models(&pool);
+
+        cube_handle* handles = malloc(sizeof(cube_handle) * n);
+        v3* centers = malloc(sizeof(v3) * n);
+        for (int i = 0; i < n; i++) {
+            handles[i] = pool_handle_at(&pool, i);
+            centers[i] = pool.center[i];
+        }
+
+        bvh tree;
+        vertex_cache cache;
+        morton_order order;
+        bvh_init(&tree);
+        vcache_init(&cache);
+        morton_init(&order);
+
+        bvh_build(&tree, &pool);
+        double miss_before = spatial_miss_rate(&tree, &pool);
+        double frame_before = morton_frame(&pool, &tree, &cache, &view, frames);
+        print("%8d %10s %10s %12.3f %12.3f %12s\n", n, "created", "-", miss_before, frame_before, "-");
+
+        double start = now_ms();
+        morton_sort(&order, &pool);
+        double sort_ms = now_ms() - start;
+
+        int lost = 0;
+        for (int i = 0; i < n; i++) {
+            int index = pool_index(&pool, handles[i]);
+            if (index < 0 || pool.center[index].x != centers[i].x || pool.center[index].y != centers[i].y) lost++;
+        }
+        int descents = 0;
+        for (int i = 1; i < n; i++) {
+            if (pool.morton[i] < pool.morton[i - 1]) descents++;
+        }
+        if (lost > 0 || descents > 0) failures++;
+
+        bvh_update(&tree, &pool);
+        double miss_after = spatial_miss_rate(&tree, &pool);
+        double frame_after = morton_frame(&pool, &tree, &cache, &view, frames);
+        print("%8d %10s %10.3f %12.3f %12.3f %12s%s\n", n, "morton", sort_ms, miss_after, frame_after,
+            (lost == 0) ? "yes" : "no", (lost > 0 || descents > 0) ? "  FAIL" : "");
+
+        // Moving a few cubes far should not trigger a re-sort, moving many should.
+        for (int i = 0; i < n / 100; i++) {
+            pool.center[i].x += 2000.0;
+            pool.dirty[i] |= DIRTY_MODEL;
+        }
+        pool_update_models(&pool);
+        bool resorted_few = morton_update(&order, &pool);
+        for (int i = 0; i < n / 4; i++) {
+            pool.center[i].y += 2000.0;
+            pool.dirty[i] |= DIRTY_MODEL;
+        }
+        pool_update_models(&pool);
+        bool resorted_many = morton_update(&order, &pool);
+        print("Re-sort after moving 1%%: %s, 25%%: %s%s\n", resorted_few ? "yes" : "no", resorted_many ? "yes" : "no",
+            (resorted_few || !resorted_many) ? "  FAIL" : "");
+        if (resorted_few || !resorted_many) failures++;
+
+        morton_destroy(&order);
+        vcache_destroy(&cache);
+        bvh_destroy(&tree);
+        free(handles);
+        free(centers);
+        pool_destroy(&pool);
+    }
+    return (failures > 0) ? 1 : 0;
+}
+
+// Pushes the clipped, snapped edges of every visible cube the way the frame's lines task does.
+static void push_scene_lines(const cube_pool* pool, const vertex_cache* cache, const frustum* view) {
+    lines_begin();
+    for (int i = 0; i < pool->count; i++) {
+        enum CullResult cull = cache->visible[i];
+        if (cull == CULL_OUTSIDE) continue;
+
+        const wire_mesh* mesh = pool->mesh[i];
+        int base = cache->base[i];
+        for (int e = 0; e < mesh->edge_count; e++) {
+            int a = base + mesh->edges[e].a;
+            int b = base + mesh->edges[e].b;
+            line_seg seg = {cache->proj_x[a], cache->proj_y[a], cache->proj_x[b], cache->proj_y[b]};
+            if (cull == CULL_INTERSECT) {
+                v3 wa = {cache->world_x[a], cache->world_y[a], cache->world_z[a]};
+                v3 wb = {cache->world_x[b], cache->world_y[b], cache->world_z[b]};
+                if (clip_edge(view, wa, wb, seg.x1, seg.y1, seg.x2, seg.y2, &seg) == CLIP_REJECTED) continue;
+            }
+            lines_push(mesh->edges[e].color, (float)(int)seg.x1, (float)(int)seg.y1, (float)(int)seg.x2, (float)(int)seg.y2);
+        }
+    }
+}
+
+// Fills the pixels whose centers the geometry quad of a line covers, what the SDL backend draws.
+static void reference_quad(framebuffer* fb, line_seg s, Uint32 argb) {
+    SDL_Vertex v[4];
+    line_quad(v, s, (SDL_Color){0});
+
+    float lo_x = v[0].position.x, hi_x = lo_x, lo_y = v[0].position.y, hi_y = lo_y;
+    for (int k = 1; k < 4; k++) {
+        lo_x = fminf(lo_x, v[k].position.x);
+        hi_x = fmaxf(hi_x, v[k].position.x);
+        lo_y = fminf(lo_y, v[k].position.y);
+        hi_y = fmaxf(hi_y, v[k].position.y);
+    }
+    for (int y = (int)fmaxf(lo_y - 1, 0); y <= (int)fminf(hi_y + 1, fb->height - 1); y++) {
+        for (int x = (int)fmaxf(lo_x - 1, 0); x <= (int)fminf(hi_x + 1, fb->width - 1); x++) {
+            float px = x + 0.5f;
+            float py = y + 0.5f;
+            // Inside when on the same side of all four edges, whichever way the quad winds.
+            int positive = 0;
+            int negative = 0;
+            for (int k = 0; k < 4; k++) {
+                SDL_FPoint a = v[k].position;
+                SDL_FPoint b = v[(k + 1) % 4].position;
+                float side = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+                if (side > 0) positive++;
+                if (side < 0) negative++;
+            }
+            if (positive == 0 || negative == 0) fb->pixels[y * fb->width + x] = argb;
+        }
+    }
+}
+
+// Worst Chebyshev distance from a drawn pixel of `a` to the nearest drawn pixel of `b`, capped at 3.
+static int coverage_distance(const framebuffer* a, const framebuffer* b, Uint32 background, int* far_pixels) {
+    int worst = 0;
+    *far_pixels = 0;
+    for (int y = 0; y < a->height; y++) {
+        for (int x = 0; x < a->width; x++) {
+            if (a->pixels[y * a->width + x] == background) continue;
+
+            int found = 3;
+            for (int r = 0; r < 3 && found == 3; r++) {
+                for (int oy = -r; oy <= r && found == 3; oy++) {
+                    for (int ox = -r; ox <= r; ox++) {
+                        int nx = x + ox;
+                        int ny = y + oy;
+                        if (nx < 0 || ny < 0 || nx >= b->width || ny >= b->height) continue;
+                        if (b->pixels[ny * b->width + nx] != background) {
+                            found = r;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (found > worst) worst = found;
+            if (found > 1) (*far_pixels)++;
+        }
+    }
+    return worst;
+}
+
+// Draws the lines pushed so far with every line kernel variant the CPU runs, timing each one.
+// Counts a failure for every variant whose pixels differ in any way from the scalar kernel's.
+static int raster_variants(framebuffer* scalar, framebuffer* variant, Uint32 background, int rounds) {
+    kernels chosen = kern;
+    int failures = 0;
+
+    assert(dispatch_select(ISA_SCALAR, &kern));
+    raster_clear(scalar, background);
+    lines_flush_soft(scalar);
+
+    print("%8s %12s %12s\n", "kernels", "raster ms", "identical");
+    for (int isa = 0; isa < ISA_COUNT; isa++) {
+        if (!dispatch_select(isa, &kern)) {
+            print("%8s %12s\n", dispatch_name(isa), "unsupported");
+            continue;
+        }
+        double start = now_ms();
+        for (int r = 0; r < rounds; r++) {
+            raster_clear(variant, background);
+            lines_flush_soft(variant);
+        }
+        double ms = (now_ms() - start) / rounds;
+
+        bool identical = memcmp(scalar->pixels, variant->pixels, sizeof(Uint32) * scalar->width * scalar->height) == 0;
+        if (!identical) failures++;
+        print("%8s %12.3f %12s%s\n", kern.name, ms, identical ? "yes" : "no", identical ? "" : "  FAIL");
+    }
+    kern = chosen;
+    return failures;
+}
+
+// Software line kernel throughput, and its coverage against the quads the SDL backend submits.
+// Fails when either one draws a pixel more than one pixel away from everything the other drew,
+// or when any kernel variant draws different pixels than the scalar one.
+static int bench_raster() {
+    const int sizes[] = {1000, 10000, 100000};
+    const int rounds = 10;
+    const Uint32 background = 0xFFFFC8C8;
+    frustum view = frustum_make(app->fov, app->screen_width, app->screen_height);
+    int failures = 0;
+
+    framebuffer soft;
+    framebuffer reference;
+    assert(raster_init(&soft, NULL, app->screen_width, app->screen_height));
+    assert(raster_init(&reference, NULL, app->screen_width, app->screen_height));
+
+    print("%8s %10s %12s %12s %12s %12s\n", "cubes", "lines", "raster ms", "ns/line", "max dist", "far pixels");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        cube_pool pool;
+        pool_init(&pool, n);
+        fill_random_scene(&pool, n, 99);
+        pool_update_models(&pool);
+
+        vertex_cache cache;
+        vcache_init(&cache);
+        vcache_build(&cache, &pool, app->fov, &view, NULL);
+        push_scene_lines(&pool, &cache, &view);
+        int lines = lines_count();
+
+        double start = now_ms();
+        for (int r = 0; r < rounds; r++) {
+            raster_clear(&soft, background);
+            lines_flush_soft(&soft);
+        }
+        double raster_ms = (now_ms() - start) / rounds;
+
+        // Only the smallest scene is compared, bigger ones paint most of the screen anyway.
+        int worst = -1;
+        int far_pixels = 0;
+        if (s == 0) {
+            raster_clear(&reference, background);
+            for (int c = 0; c < LINE_COLOR_COUNT; c++) {
+                int count;
+                const line_seg* segs = lines_segments(c, &count);
+                for (int i = 0; i < count; i++) {
+                    reference_quad(&reference, segs[i], lines_color_argb(c));
+                }
+            }
+
+            int far_a, far_b;
+            int a = coverage_distance(&soft, &reference, background, &far_a);
+            int b = coverage_distance(&reference, &soft, background, &far_b);
+            worst = (a > b) ? a : b;
+            far_pixels = far_a + far_b;
+            if (worst > 1) failures++;
+        }
+
+        char dist[16] = "-";
+        char far[16] = "-";
+        if (worst >= 0) {
+            sprintf(dist, "%d", worst);
+            sprintf(far, "%d", far_pixels);
+        }
+        print("%8d %10d %12.3f %12.2f %12s %12s%s\n", n, lines, raster_ms, raster_ms * 1e6 / lines,
+            dist, far, (worst > 1) ? "  FAIL" : "");
+        failures += raster_variants(&reference, &soft, background, rounds);
+
+        vcache_destroy(&cache);
+        pool_destroy(&pool);
+    }
+
+    raster_destroy(&soft);
+    raster_destroy(&reference);
+    return (failures > 0) ? 1 : 0;
+}
+
+// Tiled rasterizer on 1 to 16 threads against the single-threaded scalar kernel, which it has to
+// match exactly, with the kernel variant in use. Every other variant is then checked on the most threads.
+static int bench_tiles() {
+    const int sizes[] = {10000, 100000};
+    const int thread_counts[] = {1, 2, 4, 8, 16};
+    const int rounds = 10;
+    const Uint32 background = 0xFFFFC8C8;
+    frustum view = frustum_make(app->fov, app->screen_width, app->screen_height);
+    int previous_threads = jobs_thread_count();
+    bool previous_pinned = jobs_pinned();
+    int failures = 0;
+
+    framebuffer serial;
+    framebuffer tiled;
+    assert(raster_init(&serial, NULL, app->screen_width, app->screen_height));
+    assert(raster_init(&tiled, NULL, app->screen_width, app->screen_height));
+    print("%d logical CPU(s), %dx%d tiles of %d px\n", SDL_GetCPUCount(),
+        (app->screen_width + TILE_SIZE - 1) / TILE_SIZE, (app->screen_height + TILE_SIZE - 1) / TILE_SIZE, TILE_SIZE);
+
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        cube_pool pool;
+        pool_init(&pool, n);
+        fill_random_scene(&pool, n, 99);
+        pool_update_models(&pool);
+
+        vertex_cache cache;
+        vcache_init(&cache);
+        vcache_build(&cache, &pool, app->fov, &view, NULL);
+        push_scene_lines(&pool, &cache, &view);
+
+        kernels chosen = kern;
+        assert(dispatch_select(ISA_SCALAR, &kern));
+        double start = now_ms();
+        for (int r = 0; r < rounds; r++) {
+            raster_clear(&serial, background);
+            lines_flush_soft(&serial);
+        }
+        double serial_ms = (now_ms() - start) / rounds;
+        kern = chosen;
+
+        print("%d cubes, %d lines, single-threaded kernel %.3f ms\n", n, lines_count(), serial_ms);
+        print("%8s %10s %10s %10s %12s\n", "threads", "ms", "speedup", "binned", "identical");
+        double one_thread_ms = 0.0;
+        for (int k = 0; k < (int)(sizeof(thread_counts) / sizeof(thread_counts[0])); k++) {
+            jobs_shutdown();
+            jobs_init(thread_counts[k], previous_pinned);
+
+            int binned = 0;
+            start = now_ms();
+            for (int r = 0; r < rounds; r++) {
+                binned = tiler_flush(&tiled, background);
+            }
+            double ms = (now_ms() - start) / rounds;
+            if (k == 0) one_thread_ms = ms;
+
+            bool identical = memcmp(serial.pixels, tiled.pixels, sizeof(Uint32) * serial.width * serial.height) == 0;
+            if (!identical) failures++;
+            print("%8d %10.3f %10.2f %10d %12s%s\n", thread_counts[k], ms, one_thread_ms / ms, binned,
+                identical ? "yes" : "no", identical ? "" : "  FAIL");
+        }
+
+        print("%8s %10s %12s\n", "kernels", "ms", "identical");
+        for (int isa = 0; isa < ISA_COUNT; isa++) {
+            if (!dispatch_select(isa, &kern)) {
+                print("%8s %10s\n", dispatch_name(isa), "unsupported");
+                continue;
+            }
+            start = now_ms();
+            for (int r = 0; r < rounds; r++) {
+                tiler_flush(&tiled, background);
+            }
+            double ms = (now_ms() - start) / rounds;
+
+            bool identical = memcmp(serial.pixels, tiled.pixels, sizeof(Uint32) * serial.width * serial.height) == 0;
+            if (!identical) failures++;
+            print("%8s %10.3f %12s%s\n", kern.name, ms, identical ? "yes" : "no", identical ? "" : "  FAIL");
+        }
+        kern = chosen;
+
+        vcache_destroy(&cache);
+        pool_destroy(&pool);
+    }
+
+    jobs_shutdown();
+    jobs_init(previous_threads, previous_pinned);
+    raster_destroy(&serial);
+    raster_destroy(&tiled);
+    return (failures > 0) ? 1 : 0;
+}
+
+// Simulation and transform stages on 1 to 32 threads. Every thread count starts from the same scene
+// and has to end on the same bits as the single-threaded run.
+static int bench_stages() {
+    const int sizes[] = {10000, 100000, 1000000};
+    const int thread_counts[] = {1, 2, 4, 8, 16, 32};
+    const int frames = 10;
+    frustum view = frustum_make(app->fov, app->screen_width, app->screen_height);
+    int previous_threads = jobs_thread_count();
+    bool previous_pinned = jobs_pinned();
+    int failures = 0;
+
+    print("%d logical CPU(s)\n", SDL_GetCPUCount());
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        float* ref_x = NULL;
+        float* ref_y = NULL;
+        int* ref_changed = NULL;
+        int ref_count = 0;
+        int ref_changed_count = 0;
+        double one_thread_ms = 0.0;
+
+        print("%d cubes, %d frames\n", n, frames);
+        print("%8s %10s %12s %10s %8s %12s\n", "threads", "sim ms", "xform ms", "speedup", "steals", "identical");
+        for (int k = 0; k < (int)(sizeof(thread_counts) / sizeof(thread_counts[0])); k++) {
+            jobs_shutdown();
+            jobs_init(thread_counts[k], previous_pinned);
+
+            cube_pool pool;
+            pool_init(&pool, n);
+            fill_random_scene(&pool, n, 7);
+            Uint32 seed = 11;
+            for (int i = 0; i < n; i++) {
+                v3 vel = {
+                    .x = ((int)(bench_rand(&seed) % 200) - 100) / 5000.0,
+                    .y = ((int)(bench_rand(&seed) % 200) - 100) / 5000.0,
+                    .z = ((int)(bench_rand(&seed) % 200) - 100) / 5000.0
+                };
+                autorot_start(&pool, i, vel);
+            }
+            vertex_cache cache;
+            vcache_init(&cache);
+
+            double sim_ms = 0.0;
+            double xform_ms = 0.0;
+            for (int f = 0; f < frames; f++) {
+                double start = now_ms();
+                autorot_tick(&pool, BENCH_TICK);
+                double mid = now_ms();
+                pool_update_models(&pool);
+                vcache_build(&cache, &pool, app->fov, &view, NULL);
+                double end = now_ms();
+                sim_ms += mid - start;
+                xform_ms += end - mid;
+            }
+            sim_ms /= frames;
+            xform_ms /= frames;
+            if (k == 0) one_thread_ms = xform_ms;
+
+            bool identical = true;
+            if (k == 0) {
+                ref_count = cache.count;
+                ref_changed_count = pool.changed_count;
+                ref_x = malloc(sizeof(float) * ref_count);
+                ref_y = malloc(sizeof(float) * ref_count);
+                ref_changed = malloc(sizeof(int) * ref_changed_count);
+                assert(ref_x != NULL && ref_y != NULL && ref_changed != NULL);
+                memcpy(ref_x, cache.proj_x, sizeof(float) * ref_count);
+                memcpy(ref_y, cache.proj_y, sizeof(float) * ref_count);
+                memcpy(ref_changed, pool.changed, sizeof(int) * ref_changed_count);
+            } else {
+                identical = cache.count == ref_count && pool.changed_count == ref_changed_count
+                    && memcmp(ref_x, cache.proj_x, sizeof(float) * ref_count) == 0
+                    && memcmp(ref_y, cache.proj_y, sizeof(float) * ref_count) == 0
+                    && memcmp(ref_changed, pool.changed, sizeof(int) * ref_changed_count) == 0;
+            }
+            if (!identical) failures++;
+            print("%8d %10.3f %12.3f %10.2f %8d %12s%s\n", thread_counts[k], sim_ms, xform_ms, one_thread_ms / xform_ms,
+                jobs_steal_count(), identical ? "yes" : "no", identical ? "" : "  FAIL");
+
+            vcache_destroy(&cache);
+            pool_destroy(&pool);
+        }
+
+        free(ref_x);
+        free(ref_y);
+        free(ref_changed);
+    }
+
+    jobs_shutdown();
+    jobs_init(previous_threads, previous_pinned);
+    return (failures > 0) ? 1 : 0;
+}
+
+// Random graph tasks, stamped so the bench can tell whether anything ran before its dependencies.
+typedef struct order_task {
+    SDL_atomic_t* clock;
+    int started;
+    int finished;
+    int spin;
+    int worker;
+} order_task;
+
+static void order_task_run(void* ctx) {
+    order_task* t = ctx;
+    t->started = SDL_AtomicIncRef(t->clock);
+    volatile int sink = 0;
+    for (int k = 0; k < t->spin; k++) sink += k;
+    t->worker = jobs_current_worker();
+    t->finished = SDL_AtomicIncRef(t->clock);
+}
+
+// The stages of a frame minus the renderer, run as a task graph or one after the other.
+typedef struct graph_frame {
+    cube_pool* pool;
+    vertex_cache* cache;
+    framebuffer* fb;
+    Uint32* uploaded;
+    frustum view;
+    char hud[24][HUD_ROW_LENGTH];
+    char hud_drawn[24][HUD_ROW_LENGTH];
+} graph_frame;
+
+// No window, so no input either.
+static void stage_events(void* ctx) {
+}
+
+// Ticks the cubes here in place of taking a simulation snapshot.
+static void stage_sync(void* ctx) {
+    graph_frame* f = ctx;
+    autorot_tick(f->pool, BENCH_TICK);
+}
+
+static void stage_models(void* ctx) {
+    graph_frame* f = ctx;
+    pool_update_models(f->pool);
+}
+
+static void stage_transform(void* ctx) {
+    graph_frame* f = ctx;
+    vcache_build(f->cache, f->pool, app->fov, &f->view, NULL);
+}
+
+static void stage_lines(void* ctx) {
+    graph_frame* f = ctx;
+    push_scene_lines(f->pool, f->cache, &f->view);
+}
+
+static void stage_raster(void* ctx) {
+    graph_frame* f = ctx;
+    tiler_flush(f->fb, 0xFFFFC8C8);
+}
+
+static void stage_hud(void* ctx) {
+    graph_frame* f = ctx;
+    for (int i = 0; i < 24 && i < f->pool->count; i++) {
+        v3 c = f->pool->center[i];
+        v3 r = f->pool->rot[i];
+        snprintf(f->hud[i], HUD_ROW_LENGTH, "Cube %i x: %i y: %i z: %i rx: %i ry: %i rz: %i",
+            i, (int)c.x, (int)c.y, (int)c.z, (int)(r.x * RAD_TO_DEG), (int)(r.y * RAD_TO_DEG), (int)(r.z * RAD_TO_DEG));
+    }
+}
+
+// Stands in for drawing the rows into the HUD layer.
+static void stage_hud_draw(void* ctx) {
+    graph_frame* f = ctx;
+    memcpy(f->hud_drawn, f->hud, sizeof(f->hud));
+}
+
+// Stands in for the texture upload.
+static void stage_draw(void* ctx) {
+    graph_frame* f = ctx;
+    memcpy(f->uploaded, f->fb->pixels, sizeof(Uint32) * f->fb->width * f->fb->height);
+}
+
+static void stage_present(void* ctx) {
+}
+
+static const task_fn graph_stages[FRAME_TASK_COUNT] = {
+    [FRAME_EVENTS] = stage_events,
+    [FRAME_SYNC] = stage_sync,
+    [FRAME_MODELS] = stage_models,
+    [FRAME_TRANSFORM] = stage_transform,
+    [FRAME_LINES] = stage_lines,
+    [FRAME_RASTER] = stage_raster,
+    [FRAME_HUD] = stage_hud,
+    [FRAME_HUD_DRAW] = stage_hud_draw,
+    [FRAME_DRAW] = stage_draw,
+    [FRAME_PRESENT] = stage_present
+};
+
+static void setup_graph_frame(graph_frame* f, int n) {
+    pool_init(f->pool, n);
+    fill_random_scene(f->pool, n, 5);
+    Uint32 seed = 3;
+    for (int i = 0; i < n; i++) {
+        v3 vel = {
+            .x = ((int)(bench_rand(&seed) % 200) - 100) / 5000.0,
+            .y = ((int)(bench_rand(&seed) % 200) - 100) / 5000.0,
+            .z = 0.0
+        };
+        autorot_start(f->pool, i, vel);
+    }
+    vcache_init(f->cache);
+    f->view = frustum_make(app->fov, app->screen_width, app->screen_height);
+}
+
+// Task graph scheduler: dependency order on random graphs, then a frame's stages as a graph
+// against the same stages run back to back.
+static int bench_graph() {
+    const int graphs = 2000;
+    const int frames = 20;
+    const int cubes = 100000;
+    int failures = 0;
+
+    task_graph g;
+    assert(tgraph_init(&g));
+
+    order_task tasks[TGRAPH_MAX_TASKS];
+    SDL_atomic_t clock;
+    Uint32 seed = 17;
+    int violations = 0;
+    int misplaced = 0;
+    for (int r = 0; r < graphs; r++) {
+        SDL_AtomicSet(&clock, 0);
+        tgraph_reset(&g);
+        int count = 8 + bench_rand(&seed) % (TGRAPH_MAX_TASKS - 8);
+        for (int i = 0; i < count; i++) {
+            tasks[i] = (order_task){.clock = &clock, .spin = bench_rand(&seed) % 20000};
+            enum TaskAffinity affinity = (bench_rand(&seed) % 4 == 0) ? TASK_MAIN : TASK_ANY;
+            tgraph_add(&g, "task", affinity, order_task_run, &tasks[i]);
+            int deps = (i > 0) ? bench_rand(&seed) % (TGRAPH_MAX_DEPS + 1) : 0;
+            for (int d = 0; d < deps; d++) {
+                tgraph_depend(&g, i, bench_rand(&seed) % i);
+            }
+        }
+        tgraph_run(&g);
+
+        for (int i = 0; i < count; i++) {
+            for (int d = 0; d < g.tasks[i].dep_count; d++) {
+                if (tasks[g.tasks[i].deps[d]].finished > tasks[i].started) violations++;
+            }
+            if (g.tasks[i].affinity == TASK_MAIN && tasks[i].worker != 0) misplaced++;
+        }
+    }
+    print("%d random graphs on %d thread(s): %d dependency violations, %d main thread tasks elsewhere\n",
+        graphs, jobs_thread_count(), violations, misplaced);
+    if (violations > 0 || misplaced > 0) failures++;
+
+    // Same scene, same frames, once serially and once as a graph.
+    cube_pool pools[2];
+    vertex_cache caches[2];
+    framebuffer fbs[2];
+    Uint32* uploads[2];
+    graph_frame f[2];
+    double ms[2];
+    for (int k = 0; k < 2; k++) {
+        assert(raster_init(&fbs[k], NULL, app->screen_width, app->screen_height));
+        uploads[k] = malloc(sizeof(Uint32) * app->screen_width * app->screen_height);
+        assert(uploads[k] != NULL);
+        f[k] = (graph_frame){.pool = &pools[k], .cache = &caches[k], .fb = &fbs[k], .uploaded = uploads[k]};
+        setup_graph_frame(&f[k], cubes);
+    }
+
+    double start = now_ms();
+    for (int frame = 0; frame < frames; frame++) {
+        for (int t = 0; t < FRAME_TASK_COUNT; t++) {
+            graph_stages[t](&f[0]);
+        }
+    }
+    ms[0] = (now_ms() - start) / frames;
+
+    bool tracing = (app->trace != NULL) && tgraph_trace_open(app->trace);
+    double critical_ms = 0.0;
+    start = now_ms();
+    for (int frame = 0; frame < frames; frame++) {
+        tgraph_frame(&g, graph_stages, &f[1]);
+        tgraph_run(&g);
+        if (tracing) tgraph_trace_frame(&g, frame);
+        int path[TGRAPH_MAX_TASKS];
+        double path_ms;
+        tgraph_critical_path(&g, path, &path_ms);
+        critical_ms += path_ms;
+    }
+    ms[1] = (now_ms() - start) / frames;
+    if (tracing) {
+        tgraph_trace_close();
+        print("Trace written to %s\n", app->trace);
+    }
+
+    bool identical = memcmp(uploads[0], uploads[1], sizeof(Uint32) * app->screen_width * app->screen_height) == 0
+        && memcmp(f[0].hud_drawn, f[1].hud_drawn, sizeof(f[0].hud_drawn)) == 0;
+    if (!identical) failures++;
+    print("%d cubes, %d frames\n", cubes, frames);
+    print("%12s %10s %14s %12s\n", "schedule", "ms", "critical ms", "identical");
+    print("%12s %10.3f %14s %12s\n", "serial", ms[0], "-", "-");
+    print("%12s %10.3f %14.3f %12s%s\n", "graph", ms[1], critical_ms / frames,
+        identical ? "yes" : "no", identical ? "" : "  FAIL");
+
+    for (int k = 0; k < 2; k++) {
+        vcache_destroy(&caches[k]);
+        pool_destroy(&pools[k]);
+        raster_destroy(&fbs[k]);
+        free(uploads[k]);
+    }
+    tgraph_destroy(&g);
+    return (failures > 0) ? 1 : 0;
+}
+
+// Simulation thread callbacks for bench_sim(): every tick stamps all cubes with the tick number,
+// so a snapshot mixing two ticks shows up, and commands carry a sequence number in `step`.
+static Uint64 sim_bench_ticks = 0;
+static int sim_bench_applied = 0;
+static int sim_bench_out_of_order = 0;
+
+static void sim_bench_update(cube_pool* pool, double dt) {
+    sim_bench_ticks++;
+    for (int i = 0; i < pool->count; i++) {
+        pool->center[i].x = (double)sim_bench_ticks;
+        pool->dirty[i] |= DIRTY_MODEL;
+    }
+}
+
+static void sim_bench_command(cube_pool* pool, cube_handle* selected, const sim_command* cmd) {
+    if (cmd->step != sim_bench_applied + 1) sim_bench_out_of_order++;
+    sim_bench_applied = cmd->step;
+}
+
+// Simulation thread at 1 kHz against a reader polling snapshots as fast as it can for a second.
+static int bench_sim() {
+    const int n = 100000;
+    const double seconds = 1.0;
+    sim_bench_ticks = 0;
+    sim_bench_applied = 0;
+    sim_bench_out_of_order = 0;
+
+    sim_init(0.001, sim_bench_update, sim_bench_command);
+    fill_random_scene(sim_pool(), n, 21);
+    // The snapshot published before the first tick has to pass the same check.
+    for (int i = 0; i < n; i++) sim_pool()->center[i].x = 0.0;
+    cube_pool mirror;
+    pool_init(&mirror, n);
+
+    sim_start();
+    int reads = 0;
+    int fresh = 0;
+    int torn = 0;
+    int backwards = 0;
+    int misblended = 0;
+    int sent = 0;
+    int dropped = 0;
+    double worst_acquire_us = 0.0;
+    Uint64 last_serial = 0;
+    Uint64 last_tick = 0;
+    double start = now_ms();
+    while (now_ms() - start < seconds * 1000.0) {
+        double before = now_ms();
+        const scene_snapshot* snap = sim_latest();
+        double took = (now_ms() - before) * 1000.0;
+        if (took > worst_acquire_us) worst_acquire_us = took;
+        reads++;
+
+        if (snap->serial != last_serial) {
+            fresh++;
+            if (snap->tick < last_tick) backwards++;
+            for (int i = 0; i < snap->count; i++) {
+                if (snap->center[i].x != (double)snap->tick) {
+                    torn++;
+                    break;
+                }
+            }
+            // Half way between the previous snapshot and this one, every cube has to sit in the middle.
+            sim_mirror(snap, &mirror);
+            sim_blend(&mirror, 0.5);
+            double middle = ((double)(fresh > 1 ? last_tick : snap->tick) + (double)snap->tick) / 2.0;
+            for (int i = 0; i < mirror.count; i++) {
+                if (mirror.center[i].x != middle) {
+                    misblended++;
+                    break;
+                }
+            }
+            sim_blend(&mirror, 1.0);
+            last_serial = snap->serial;
+            last_tick = snap->tick;
+        }
+
+        if (sim_send((sim_command){.step = sent + 1})) {
+            sent++;
+        } else {
+            dropped++;
+        }
+    }
+    sim_stop();
+
+    // Commands still queued when it stopped.
+    int pending = sent - sim_bench_applied;
+    bool mirror_ok = mirror.count == n;
+    for (int s = 0; s < n && mirror_ok; s++) {
+        mirror_ok = mirror.center[s].x == (double)last_tick;
+    }
+
+    // Models built from the mirrored quaternions against the simulation's own angles. Translations
+    // are left out, the simulation may have ticked again after the last snapshot was read.
+    cube_pool* simulated = sim_pool();
+    for (int i = 0; i < simulated->count; i++) simulated->dirty[i] = DIRTY_MODEL;
+    pool_update_models(simulated);
+    pool_update_models(&mirror);
+    double worst_model = 0.0;
+    for (int i = 0; i < n && mirror_ok; i++) {
+        for (int k = 0; k < 12; k++) {
+            if (k % 4 == 3) continue;
+            double d = fabs((double)mirror.model[i].m[k] - simulated->model[i].m[k]);
+            if (d > worst_model) worst_model = d;
+        }
+    }
+
+    print("%d cubes, %llu ticks in %.1f s\n", n, (unsigned long long)sim_bench_ticks, seconds);
+    print("Reads: %d, new snapshots: %d, slowest read %.2f us\n", reads, fresh, worst_acquire_us);
+    print("Torn snapshots: %d, ticks going backwards: %d, wrong blends: %d, mirror up to date: %s\n",
+        torn, backwards, misblended, mirror_ok ? "yes" : "no");
+    print("Commands sent: %d, dropped on a full queue: %d, applied: %d, out of order: %d, still queued: %d\n",
+        sent, dropped, sim_bench_applied, sim_bench_out_of_order, pending);
+    print("Largest model difference through quaternions: %g\n", worst_model);
+
+    pool_destroy(&mirror);
+    sim_destroy();
+    return (torn > 0 || backwards > 0 || misblended > 0 || sim_bench_out_of_order > 0 || !mirror_ok || worst_model > 1e-3) ? 1 : 0;
+}
+
+// bench_catchup(): ticks take longer than they are long while catchup_slow is set, and move
+// nothing while catchup_resting is.
+static SDL_atomic_t catchup_slow;
+static SDL_atomic_t catchup_resting;
+
+static void catchup_update(cube_pool* pool, double dt) {
+    if (SDL_AtomicGet(&catchup_slow)) SDL_Delay(15);
+    if (SDL_AtomicGet(&catchup_resting)) return;
+    pool->center[0].x += dt;
+    pool->dirty[0] |= DIRTY_MODEL;
+}
+
+// Follows the simulation for `seconds`, returns the newest snapshot and the largest lag seen
+// between when a snapshot's last tick was due and now.
+static const scene_snapshot* catchup_follow(double seconds, double* worst_lag_ms, int* backwards) {
+    const scene_snapshot* snap = sim_latest();
+    double last_time = snap->time;
+    double start = now_ms();
+    while (now_ms() - start < seconds * 1000.0) {
+        SDL_Delay(1);
+        snap = sim_latest();
+        double lag = (double)(SDL_GetPerformanceCounter() - snap->stamp) * 1000.0 / SDL_GetPerformanceFrequency();
+        if (lag > *worst_lag_ms) *worst_lag_ms = lag;
+        if (snap->time < last_time) (*backwards)++;
+        last_time = snap->time;
+    }
+    return snap;
+}
+
+// A 100 Hz simulation whose ticks suddenly take 15 ms, then get cheap again. It has to stay close
+// to real time by dropping backlog, drop its rate while overloaded, and get back to 100 Hz after.
+static int bench_catchup() {
+    const double dt = 0.01;
+    SDL_AtomicSet(&catchup_slow, 0);
+    SDL_AtomicSet(&catchup_resting, 1);
+    sim_init(dt, catchup_update, NULL);
+    fill_random_scene(sim_pool(), 1000, 5);
+    sim_start();
+
+    // Ticks that move nothing publish nothing.
+    double worst_lag_ms = 0.0;
+    int backwards = 0;
+    Uint64 resting_serial = sim_latest()->serial;
+    const scene_snapshot* snap = catchup_follow(0.3, &worst_lag_ms, &backwards);
+    int resting_published = (int)(snap->serial - resting_serial);
+    print("Resting:    %6.1f Hz, %d snapshots published\n", 1.0 / snap->dt, resting_published);
+    SDL_AtomicSet(&catchup_resting, 0);
+
+    worst_lag_ms = 0.0;
+    snap = catchup_follow(0.5, &worst_lag_ms, &backwards);
+    print("Moving:     %6.1f Hz, %.2f s dropped\n", 1.0 / snap->dt, snap->dropped);
+
+    SDL_AtomicSet(&catchup_slow, 1);
+    worst_lag_ms = 0.0;
+    snap = catchup_follow(1.5, &worst_lag_ms, &backwards);
+    double loaded_dt = snap->dt;
+    double loaded_dropped = snap->dropped;
+    print("Overloaded: %6.1f Hz, %.2f s dropped, simulation at most %.1f ms behind\n",
+        1.0 / loaded_dt, loaded_dropped, worst_lag_ms);
+
+    SDL_AtomicSet(&catchup_slow, 0);
+    snap = catchup_follow(3.0, &worst_lag_ms, &backwards);
+    double recovered_dt = snap->dt;
+    print("Recovered:  %6.1f Hz, %.2f s dropped\n", 1.0 / recovered_dt, snap->dropped);
+    print("Simulated time going backwards: %d\n", backwards);
+
+    sim_stop();
+    sim_destroy();
+
+    bool ok = loaded_dt > dt && loaded_dropped > 0.0 && recovered_dt == dt && backwards == 0 && resting_published == 0;
+    // Unbounded catch-up would fall ever further behind, bounded it stays within a few ticks.
+    ok = ok && worst_lag_ms < 250.0;
+    return ok ? 0 : 1;
+}
+
+// Stands in for drawing a frame, keeps the CPU busy for `ms`.
+static void busy_ms(double ms) {
+    double until = now_ms() + ms;
+    while (now_ms() < until) {
+    }
+}
+
+// Frames with 2 ms of work, paced to 120 Hz for a second, against running them flat out.
+// CPU is the share of wall time spent working or spinning, sleeping is what it gives back.
+static int bench_pacing() {
+    const double target_hz = 120.0;
+    const double work_ms = 2.0;
+    const int frames = 120;
+    const double period_ms = 1000.0 / target_hz;
+    bool ok = true;
+
+    print("    mode   frame ms   jitter ms   worst ms   missed    CPU\n");
+    for (int mode = PACE_NONE; mode <= PACE_TIMER; mode++) {
+        frame_pacer pacer;
+        pacer_init(&pacer, mode, target_hz);
+        // Settles the learned oversleep before measuring.
+        for (int f = 0; f < 10; f++) {
+            busy_ms(work_ms);
+            pacer_wait(&pacer);
+        }
+        pacer.missed = 0;
+
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        double worst = 0.0;
+        double busy = 0.0;
+        for (int f = 0; f < frames; f++) {
+            busy_ms(work_ms);
+            pacer_wait(&pacer);
+            sum += pacer.frame_ms;
+            sum_sq += pacer.frame_ms * pacer.frame_ms;
+            busy += pacer.work_ms + pacer.spin_ms;
+            double off = fabs(pacer.frame_ms - ((mode == PACE_TIMER) ? period_ms : work_ms));
+            if (off > worst) worst = off;
+        }
+        double mean = sum / frames;
+        double jitter = sqrt(fmax(sum_sq / frames - mean * mean, 0.0));
+        print("%8s %10.3f %11.3f %10.3f %8d %5.1f%%\n",
+            pace_mode_name(mode), mean, jitter, worst, pacer.missed, 100.0 * busy / sum);
+
+        if (mode == PACE_TIMER) {
+            // Deadlines stay on the period, a missed one is not made up for by a short frame.
+            ok = fabs(mean - period_ms) < period_ms * 0.02 && pacer.missed < frames / 20;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// Frame cost of a made up scene for bench_dynres(): a fixed part plus a part that goes with the pixel count.
+static double dynres_cost(double fixed_ms, double full_raster_ms, double scale, Uint32* seed) {
+    double noise = ((double)(bench_rand(seed) % 1000) / 1000.0 - 0.5) * 0.2;
+    return fixed_ms + full_raster_ms * scale * scale + noise;
+}
+
+// Dynamic resolution against a scene whose raster cost jumps over the budget and back down,
+// then one no scale can fit. Checks it gets under budget, holds steady there, and recovers.
+static int bench_dynres() {
+    const double budget_ms = 8.0;
+    const double fixed_ms = 2.0;
+    const double phases[] = {4.0, 12.0, 4.0, 40.0};
+    const char* names[] = {"light", "heavy", "light", "hopeless"};
+    const int frames = 240;
+    Uint32 seed = 11;
+    bool ok = true;
+
+    dynres_controller dr;
+    dynres_init(&dr, budget_ms, DYNRES_MIN_SCALE);
+
+    print("   phase    scale    frame ms   over budget   scale changes\n");
+    for (int p = 0; p < 4; p++) {
+        double scale = dr.scale;
+        int over = 0;
+        int changes = 0;
+        double settled_ms = 0.0;
+        for (int f = 0; f < frames; f++) {
+            double ms = dynres_cost(fixed_ms, phases[p], scale, &seed);
+            double next = dynres_update(&dr, ms);
+            // Only the second half counts, the first is for settling.
+            if (f >= frames / 2) {
+                if (ms > budget_ms) over++;
+                if (next != scale) changes++;
+                settled_ms += ms;
+            }
+            scale = next;
+        }
+        settled_ms /= frames / 2;
+        print("%8s %8.3f %11.3f %13d %15d\n", names[p], scale, settled_ms, over, changes);
+
+        bool fits = fixed_ms + phases[p] * DYNRES_MIN_SCALE * DYNRES_MIN_SCALE < budget_ms;
+        if (fits) {
+            ok = ok && over == 0 && changes < frames / 20;
+        } else {
+            ok = ok && scale == DYNRES_MIN_SCALE;
+        }
+        if (p == 2) ok = ok && scale == 1.0;
+    }
+    return ok ? 0 : 1;
+}
+
+// Stage costs of a made up frame for bench_governor(), with `step` and every step before it shed.
+static double governor_frame(double lines_ms, double update_ms, int step, double* stage_ms, Uint32* seed) {
+    const double fixed_ms = 1.0;
+    stage_ms[GOV_STAGE_HUD] = (step >= GOV_HUD) ? 0.3 : 1.5;
+    stage_ms[GOV_STAGE_LINES] = (step >= GOV_LOD) ? lines_ms * 0.5 : lines_ms;
+    stage_ms[GOV_STAGE_UPDATE] = (step >= GOV_AMORTIZE) ? update_ms / GOVERNOR_STRIDE : update_ms;
+    double noise = ((double)(bench_rand(seed) % 1000) / 1000.0 - 0.5) * 0.2;
+    return fixed_ms + stage_ms[GOV_STAGE_HUD] + stage_ms[GOV_STAGE_LINES] + stage_ms[GOV_STAGE_UPDATE] + noise;
+}
+
+// Frame budget governor against load going up in steps, past anything shedding can save, and back.
+// Checks each load ends up with just the steps it needs shed, in order, without flipping back and
+// forth, and that everything is restored once the load is gone.
+static int bench_governor() {
+    const double budget_ms = 8.0;
+    typedef struct governor_phase {
+        const char* name;
+        double lines_ms;
+        double update_ms;
+        int expected;   // enum GovernorStep it should end up at
+        bool fits;      // Whether shedding gets it under budget at all
+    } governor_phase;
+    const governor_phase phases[] = {
+        {"light", 2.0, 1.0, GOV_NONE, true},
+        {"heavy", 6.0, 1.0, GOV_LOD, true},
+        {"heavier", 6.0, 6.0, GOV_AMORTIZE, true},
+        {"light", 2.0, 1.0, GOV_NONE, true},
+        {"hopeless", 20.0, 6.0, GOV_AMORTIZE, false},
+        {"light", 2.0, 1.0, GOV_NONE, true}
+    };
+    const int phase_count = (int)(sizeof(phases) / sizeof(phases[0]));
+    const int frames = 300;
+    Uint32 seed = 23;
+    bool ok = true;
+
+    frame_governor gov;
+    governor_init(&gov, budget_ms);
+
+    print("   phase     shed   frame ms   over budget   changes   last change\n");
+    int step = GOV_NONE;
+    for (int p = 0; p < phase_count; p++) {
+        int changes = 0;
+        int last_change = -1;
+        int over = 0;
+        double settled_ms = 0.0;
+        for (int f = 0; f < frames; f++) {
+            double stage_ms[GOV_STAGE_COUNT];
+            double ms = governor_frame(phases[p].lines_ms, phases[p].update_ms, step, stage_ms, &seed);
+            int next = governor_update(&gov, ms, stage_ms, true);
+            if (next != step) {
+                // One step at a time, shed in order and restored in reverse.
+                ok = ok && (next == step + 1 || next == step - 1);
+                changes++;
+                last_change = f;
+            }
+            if (f >= frames * 3 / 4) {
+                if (ms > budget_ms) over++;
+                settled_ms += ms;
+            }
+            step = next;
+        }
+        settled_ms /= frames - frames * 3 / 4;
+        print("%8s %8s %10.3f %13d %9d %13d\n",
+            phases[p].name, governor_step_name(step), settled_ms, over, changes, last_change);
+
+        // Settled by the last quarter, at just the steps the load needs.
+        ok = ok && step == phases[p].expected && last_change < frames * 3 / 4;
+        if (phases[p].fits) ok = ok && over == 0;
+        ok = ok && changes <= GOV_STEP_COUNT - 1;
+    }
+    for (int step = GOV_NONE; step < GOV_STEP_COUNT; step++) {
+        print("%8s: %i frames, shed %i times, restored %i times\n",
+            governor_step_name(step), gov.frames[step], gov.sheds[step], gov.restores[step]);
+    }
+    return ok ? 0 : 1;
+}
+
+typedef struct bench_entry {
+    const char* name;
+    int (*run)();
+} bench_entry;
+
+static const bench_entry benches[] = {
+    {"text", bench_text},
+    {"pool", bench_pool},
+    {"layout", bench_layout},
+    {"xform", bench_xform},
+    {"model", bench_model},
+    {"drift", bench_drift},
+    {"sincos", bench_sincos},
+    {"mesh", bench_mesh},
+    {"clip", bench_clip},
+    {"bvh", bench_bvh},
+    {"morton", bench_morton},
+    {"raster", bench_raster},
+    {"tiles", bench_tiles},
+    {"stages", bench_stages},
+    {"graph", bench_graph},
+    {"sim", bench_sim},
+    {"catchup", bench_catchup},
+    {"pacing", bench_pacing},
+    {"dynres", bench_dynres},
+    {"governor", bench_governor},
+};
+
+int bench_run(const char* name) {
+    int count = (int)(sizeof(benches) / sizeof(benches[0]));
+    for (int i = 0; i < count; i++) {
+        if (SDL_strcmp(benches[i].name, name) == 0) {
+            return benches[i].run();
+        }
+    }
+
+    print("Unknown benchmark \"%s\", available:\n", name);
+    for (int i = 0; i < count; i++) {
+        printf("  %s\n", benches[i].name);
+    }
+    return SDL_strcmp(name, "list") == 0 ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<assert.h>
+#include<malloc.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<pool.h>
+#include<mesh.h>
+#include<bvh.h>
+
+#define BVH_MAX_DEPTH 64
+
+void bvh_init(bvh* tree) {
+    memset(tree, 0, sizeof(bvh));
+}
+
+void bvh_destroy(bvh* tree) {
+    free(tree->nodes);
+    free(tree->parent);
+    free(tree->marked);
+    free(tree->items);
+    free(tree->leaf_of);
+    free(tree->boxes);
+    free(tree->refit_nodes);
+    memset(tree, 0, sizeof(bvh));
+}
+
+static void reserve(bvh* tree, int cubes) {
+    if (cubes <= tree->capacity) return;
+
+    int grown = (tree->capacity > 0) ? tree->capacity : 64;
+    while (grown < cubes) grown *= 2;
+
+    // A binary tree whose leaves hold at least one cube has fewer than twice as many nodes as cubes.
+    int nodes = grown * 2;
+    tree->nodes = realloc(tree->nodes, sizeof(bvh_node) * nodes);
+    tree->parent = realloc(tree->parent, sizeof(int) * nodes);
+    tree->marked = realloc(tree->marked, sizeof(Uint8) * nodes);
+    tree->refit_nodes = realloc(tree->refit_nodes, sizeof(int) * nodes);
+    tree->items = realloc(tree->items, sizeof(int) * grown);
+    tree->leaf_of = realloc(tree->leaf_of, sizeof(int) * grown);
+    tree->boxes = realloc(tree->boxes, sizeof(aabb) * grown);
+    assert(tree->nodes != NULL && tree->parent != NULL && tree->marked != NULL && tree->refit_nodes != NULL);
+    assert(tree->items != NULL && tree->leaf_of != NULL && tree->boxes != NULL);
+    tree->capacity = grown;
+}
+
+aabb bvh_cube_box(const cube_pool* pool, int index) {
+    const float* m = pool->model[index].m;
+    float box = pool->mesh[index]->box;
+
+    // The model space box is (±box, ±box, ±box), each world axis reaches as far as the
+    // absolute values of its matrix row allow.
+    aabb out;
+    for (int r = 0; r < 3; r++) {
+        float reach = box * (fabsf(m[r * 4 + 0]) + fabsf(m[r * 4 + 1]) + fabsf(m[r * 4 + 2]));
+        out.min[r] = m[r * 4 + 3] - reach;
+        out.max[r] = m[r * 4 + 3] + reach;
+    }
+    return out;
+}
+
+static void box_union(aabb* into, const aabb* other) {
+    for (int k = 0; k < 3; k++) {
+        if (other->min[k] < into->min[k]) into->min[k] = other->min[k];
+        if (other->max[k] > into->max[k]) into->max[k] = other->max[k];
+    }
+}
+
+static float centroid(const bvh* tree, int cube, int axis) {
+    return tree->boxes[cube].min[axis] + tree->boxes[cube].max[axis];
+}
+
+// Reorders items[first, first + count) so that the one at `nth` has every smaller centroid before it.
+static void select_nth(bvh* tree, int first, int count, int nth, int axis) {
+    int* items = tree->items;
+    int lo = first;
+    int hi = first + count - 1;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        float a = centroid(tree, items[lo], axis);
+        float b = centroid(tree, items[mid], axis);
+        float c = centroid(tree, items[hi], axis);
+        float pivot = (a < b) ? ((b < c) ? b : ((a < c) ? c : a)) : ((a < c) ? a : ((b < c) ? c : b));
+
+        int i = lo;
+        int j = hi;
+        while (i <= j) {
+            while (centroid(tree, items[i], axis) < pivot) i++;
+            while (centroid(tree, items[j], axis) > pivot) j--;
+            if (i <= j) {
+                int swap = items[i];
+                items[i] = items[j];
+                items[j] = swap;
+                i++;
+                j--;
+            }
+        }
+
+        if (nth <= j) hi = j;
+        else if (nth >= i) lo = i;
+        else return;
+    }
+}
+
+static void build_node(bvh* tree, int node, int first, int count, int depth) {
+    bvh_node* n = &tree->nodes[node];
+    n->box = tree->boxes[tree->items[first]];
+    for (int i = 1; i < count; i++) {
+        box_union(&n->box, &tree->boxes[tree->items[first + i]]);
+    }
+
+    if (count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH) {
+        n->first = first;
+        n->count = count;
+        for (int i = 0; i < count; i++) {
+            tree->leaf_of[tree->items[first + i]] = node;
+        }
+        return;
+    }
+
+    // Split along the axis the centroids spread the most on.
+    float lo[3];
+    float hi[3];
+    for (int k = 0; k < 3; k++) {
+        lo[k] = hi[k] = centroid(tree, tree->items[first], k);
+    }
+    for (int i = 1; i < count; i++) {
+        for (int k = 0; k < 3; k++) {
+            float c = centroid(tree, tree->items[first + i], k);
+            if (c < lo[k]) lo[k] = c;
+            if (c > hi[k]) hi[k] = c;
+        }
+    }
+    int axis = 0;
+    if (hi[1] - lo[1] > hi[axis] - lo[axis]) axis = 1;
+    if (hi[2] - lo[2] > hi[axis] - lo[axis]) axis = 2;
+
+    int half = count / 2;
+    select_nth(tree, first, count, first + half, axis);
+
+    int left = tree->node_count;
+    tree->node_count += 2;
+    n->first = left;
+    n->count = 0;
+    tree->parent[left] = node;
+    tree->parent[left + 1] = node;
+
+    build_node(tree, left, first, half, depth + 1);
+    build_node(tree, left + 1, first + half, count - half, depth + 1);
+}
+
+void bvh_build(bvh* tree, const cube_pool* pool) {
+    reserve(tree, pool->count);
+    tree->cube_count = pool->count;
+    tree->layout_version = pool->layout_version;
+    tree->built = true;
+    tree->node_count = 0;
+
+    for (int i = 0; i < pool->count; i++) {
+        tree->boxes[i] = bvh_cube_box(pool, i);
+        tree->items[i] = i;
+    }
+    if (pool->count == 0) return;
+
+    tree->node_count = 1;
+    tree->parent[0] = -1;
+    build_node(tree, 0, 0, pool->count, 0);
+    memset(tree->marked, 0, sizeof(Uint8) * tree->node_count);
+}
+
+static int descending(const void* a, const void* b) {
+    return *(const int*)b - *(const int*)a;
+}
+
+int bvh_refit(bvh* tree, const cube_pool* pool) {
+    int marked = 0;
+    for (int c = 0; c < pool->changed_count; c++) {
+        int cube = pool->changed[c];
+        aabb box = bvh_cube_box(pool, cube);
+        if (memcmp(&box, &tree->boxes[cube], sizeof(aabb)) == 0) continue;
+        tree->boxes[cube] = box;
+
+        // Ancestors of an already marked node are marked too.
+        for (int node = tree->leaf_of[cube]; node >= 0 && !tree->marked[node]; node = tree->parent[node]) {
+            tree->marked[node] = 1;
+            tree->refit_nodes[marked++] = node;
+        }
+    }
+
+    // Children come after their parents, so higher indices first refits bottom-up.
+    // Once a good part of the tree is touched, sweeping every node beats sorting the marked ones.
+    bool sweep = marked > tree->node_count / 8;
+    if (!sweep) qsort(tree->refit_nodes, marked, sizeof(int), descending);
+    int remaining = sweep ? tree->node_count : marked;
+    for (int r = 0; r < remaining; r++) {
+        int node = sweep ? tree->node_count - 1 - r : tree->refit_nodes[r];
+        if (!tree->marked[node]) continue;
+
+        bvh_node* n = &tree->nodes[node];
+        if (n->count > 0) {
+            n->box = tree->boxes[tree->items[n->first]];
+            for (int i = 1; i < n->count; i++) {
+                box_union(&n->box, &tree->boxes[tree->items[n->first + i]]);
+            }
+        } else {
+            n->box = tree->nodes[n->first].box;
+            box_union(&n->box, &tree->nodes[n->first + 1].box);
+        }
+        tree->marked[node] = 0;
+    }
+    return marked;
+}
+
+void bvh_update(bvh* tree, const cube_pool* pool) {
+    tree->rebuilt = !tree->built || tree->layout_version != pool->layout_version;
+    if (tree->rebuilt) {
+        bvh_build(tree, pool);
+        tree->refit_count = 0;
+    } else {
+        tree->refit_count = bvh_refit(tree, pool);
+    }
+}
+
+int bvh_cull(const bvh* tree, const frustum* view, Uint8* visible) {
+    memset(visible, CULL_OUTSIDE, sizeof(Uint8) * tree->cube_count);
+    if (tree->node_count == 0) return 0;
+
+    // Nodes paired with what is already known about them, CULL_INTERSECT meaning still to test.
+    int stack[BVH_MAX_DEPTH * 2 + 2];
+    Uint8 known[BVH_MAX_DEPTH * 2 + 2];
+    int top = 0;
+    stack[top] = 0;
+    known[top++] = CULL_INTERSECT;
+
+    int shown = 0;
+    while (top > 0) {
+        top--;
+        const bvh_node* n = &tree->nodes[stack[top]];
+        enum CullResult result = known[top];
+        if (result == CULL_INTERSECT) {
+            result = frustum_test_aabb(view, n->box.min, n->box.max);
+            if (result == CULL_OUTSIDE) continue;
+        }
+
+        if (n->count > 0) {
+            for (int i = 0; i < n->count; i++) {
+                int cube = tree->items[n->first + i];
+                enum CullResult cube_result = result;
+                if (result == CULL_INTERSECT) {
+                    const aabb* box = &tree->boxes[cube];
+                    cube_result = frustum_test_aabb(view, box->min, box->max);
+                }
+                visible[cube] = (Uint8)cube_result;
+                if (cube_result != CULL_OUTSIDE) shown++;
+            }
+        } else {
+            // A subtree entirely inside is not tested any further.
+            stack[top] = n->first;
+            known[top++] = result;
+            stack[top] = n->first + 1;
+            known[top++] = result;
+        }
+    }
+    return tree->cube_count - shown;
+}
@@ -0,0 +1,157 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<clip.h>
+
+static void set_plane(double* plane, double a, double b, double c, double d) {
+    double len = sqrt(a * a + b * b + c * c);
+    plane[0] = a / len;
+    plane[1] = b / len;
+    plane[2] = c / len;
+    plane[3] = d / len;
+}
+
+frustum frustum_make(double fov, int width, int height) {
+    frustum f = {
+        .fov = fov,
+        .width = (float)width,
+        .height = (float)height,
+        .enabled = fov > 0
+    };
+
+    // x * fov / (fov + z) stays within [0, width] exactly when x >= 0 and width * (fov + z) - fov * x >= 0,
+    // same for y against height.
+    set_plane(f.plane[PLANE_LEFT], 1, 0, 0, 0);
+    set_plane(f.plane[PLANE_TOP], 0, 1, 0, 0);
+    set_plane(f.plane[PLANE_RIGHT], -fov, 0, width, width * fov);
+    set_plane(f.plane[PLANE_BOTTOM], 0, -fov, height, height * fov);
+    set_plane(f.plane[PLANE_NEAR], 0, 0, 1, fov - CLIP_NEAR);
+    return f;
+}
+
+enum CullResult frustum_test_sphere(const frustum* f, v3 center, double radius) {
+    if (!f->enabled) return CULL_INTERSECT;
+
+    enum CullResult result = CULL_INSIDE;
+    for (int p = 0; p < PLANE_COUNT; p++) {
+        const double* pl = f->plane[p];
+        double dist = pl[0] * center.x + pl[1] * center.y + pl[2] * center.z + pl[3];
+        if (dist < -radius) return CULL_OUTSIDE;
+        if (dist < radius) result = CULL_INTERSECT;
+    }
+    return result;
+}
+
+enum CullResult frustum_test_aabb(const frustum* f, const float* min, const float* max) {
+    if (!f->enabled) return CULL_INTERSECT;
+
+    double c[3];
+    double h[3];
+    for (int k = 0; k < 3; k++) {
+        c[k] = ((double)min[k] + max[k]) * 0.5;
+        h[k] = ((double)max[k] - min[k]) * 0.5;
+    }
+
+    enum CullResult result = CULL_INSIDE;
+    for (int p = 0; p < PLANE_COUNT; p++) {
+        const double* pl = f->plane[p];
+        // Distance of the center, and how far the box reaches along the normal.
+        double dist = pl[0] * c[0] + pl[1] * c[1] + pl[2] * c[2] + pl[3];
+        double reach = fabs(pl[0]) * h[0] + fabs(pl[1]) * h[1] + fabs(pl[2]) * h[2];
+        if (dist < -reach) return CULL_OUTSIDE;
+        if (dist < reach) result = CULL_INTERSECT;
+    }
+    return result;
+}
+
+enum OutCode {
+    OUT_LEFT = 1 << 0,
+    OUT_RIGHT = 1 << 1,
+    OUT_TOP = 1 << 2,
+    OUT_BOTTOM = 1 << 3
+};
+
+static int out_code(float x, float y, float x_max, float y_max) {
+    int code = 0;
+    if (x < 0) code |= OUT_LEFT;
+    else if (x > x_max) code |= OUT_RIGHT;
+    if (y < 0) code |= OUT_TOP;
+    else if (y > y_max) code |= OUT_BOTTOM;
+    return code;
+}
+
+// Cohen-Sutherland against [0, x_max] x [0, y_max], false when nothing is left.
+static bool clip_rect(line_seg* s, float x_max, float y_max) {
+    int code_a = out_code(s->x1, s->y1, x_max, y_max);
+    int code_b = out_code(s->x2, s->y2, x_max, y_max);
+
+    while (true) {
+        if (!(code_a | code_b)) return true;
+        if (code_a & code_b) return false;
+
+        // Move the endpoint that is outside onto the edge it is outside of.
+        int code = code_a ? code_a : code_b;
+        float dx = s->x2 - s->x1;
+        float dy = s->y2 - s->y1;
+        float x, y;
+        if (code & OUT_BOTTOM) {
+            x = s->x1 + dx * (y_max - s->y1) / dy;
+            y = y_max;
+        } else if (code & OUT_TOP) {
+            x = s->x1 + dx * (0 - s->y1) / dy;
+            y = 0;
+        } else if (code & OUT_RIGHT) {
+            y = s->y1 + dy * (x_max - s->x1) / dx;
+            x = x_max;
+        } else {
+            y = s->y1 + dy * (0 - s->x1) / dx;
+            x = 0;
+        }
+
+        if (code == code_a) {
+            s->x1 = x;
+            s->y1 = y;
+            code_a = out_code(x, y, x_max, y_max);
+        } else {
+            s->x2 = x;
+            s->y2 = y;
+            code_b = out_code(x, y, x_max, y_max);
+        }
+    }
+}
+
+enum ClipResult clip_edge(const frustum* f, v3 wa, v3 wb, float pax, float pay, float pbx, float pby, line_seg* out) {
+    bool clipped = false;
+    double da = f->fov + wa.z;
+    double db = f->fov + wb.z;
+
+    *out = (line_seg){.x1 = pax, .y1 = pay, .x2 = pbx, .y2 = pby};
+    if (da < CLIP_NEAR || db < CLIP_NEAR) {
+        if (da < CLIP_NEAR && db < CLIP_NEAR) return CLIP_REJECTED;
+
+        // Cut at the near plane in world space and project the new endpoint, before anything divides
+        // by a depth that is tiny or negative.
+        double t = (CLIP_NEAR - da) / (db - da);
+        v3 cut = v_add(wa, (v3){.x = (wb.x - wa.x) * t, .y = (wb.y - wa.y) * t, .z = (wb.z - wa.z) * t});
+        double scale = f->fov / CLIP_NEAR;
+        if (da < CLIP_NEAR) {
+            out->x1 = (float)(cut.x * scale);
+            out->y1 = (float)(cut.y * scale);
+        } else {
+            out->x2 = (float)(cut.x * scale);
+            out->y2 = (float)(cut.y * scale);
+        }
+        clipped = true;
+    }
+
+    // The last row and column, so that snapping to whole pixels keeps everything on screen.
+    line_seg before = *out;
+    if (!clip_rect(out, f->width - 1, f->height - 1)) return CLIP_REJECTED;
+    if (out->x1 != before.x1 || out->y1 != before.y1 || out->x2 != before.x2 || out->y2 != before.y2) {
+        clipped = true;
+    }
+    return clipped ? CLIP_CLIPPED : CLIP_ACCEPTED;
+}
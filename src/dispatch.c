@@ -0,0 +1,108 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<xform.h>
+#include<trig.h>
+#include<raster.h>
+#include<dispatch.h>
+
+// Runtime kernel selection.
+// The build carries every variant, the CPU is probed once and the table below is filled with the
+// best one. Hot loops call through `kern` so no per-call feature checks happen.
+
+kernels kern = {
+    .isa = ISA_SCALAR,
+    .name = "scalar",
+    .xform_cubes = xform_cubes_scalar,
+    .xform_points = xform_points_scalar,
+    .project = project_scalar,
+    .sincos_poly = trig_poly_batch_scalar,
+    .raster_line = raster_line_scalar
+};
+
+static const kernels variants[ISA_COUNT] = {
+    [ISA_SCALAR] = {
+        .isa = ISA_SCALAR,
+        .name = "scalar",
+        .xform_cubes = xform_cubes_scalar,
+        .xform_points = xform_points_scalar,
+        .project = project_scalar,
+        .sincos_poly = trig_poly_batch_scalar,
+        .raster_line = raster_line_scalar
+    },
+    [ISA_SSE2] = {
+        .isa = ISA_SSE2,
+        .name = "sse2",
+        .xform_cubes = xform_cubes_sse2,
+        .xform_points = xform_points_sse2,
+        .project = project_sse2,
+        .sincos_poly = trig_poly_batch_scalar,
+        .raster_line = raster_line_sse2
+    },
+    [ISA_AVX2] = {
+        .isa = ISA_AVX2,
+        .name = "avx2",
+        .xform_cubes = xform_cubes_avx2,
+        .xform_points = xform_points_avx2,
+        .project = project_avx2,
+        .sincos_poly = trig_poly_batch_avx2,
+        .raster_line = raster_line_avx2
+    },
+};
+
+bool dispatch_supported(enum IsaLevel isa) {
+#if defined(__i386__) || defined(__x86_64__)
+    switch (isa) {
+        case ISA_SCALAR: return true;
+        case ISA_SSE2: return SDL_HasSSE2();
+        case ISA_AVX2: return SDL_HasAVX2();
+        default: return false;
+    }
+#else
+    // Only the scalar kernels are built off x86.
+    return isa == ISA_SCALAR;
+#endif
+}
+
+const char* dispatch_name(enum IsaLevel isa) {
+    return (isa >= 0 && isa < ISA_COUNT) ? variants[isa].name : "unknown";
+}
+
+bool dispatch_select(enum IsaLevel isa, kernels* out) {
+    if (isa < 0 || isa >= ISA_COUNT || !dispatch_supported(isa)) return false;
+    *out = variants[isa];
+    return true;
+}
+
+void dispatch_init(const char* force) {
+    enum IsaLevel best = ISA_SCALAR;
+    for (int isa = ISA_COUNT - 1; isa > ISA_SCALAR; isa--) {
+        if (dispatch_supported(isa)) {
+            best = isa;
+            break;
+        }
+    }
+
+    enum IsaLevel chosen = best;
+    if (force != NULL) {
+        int forced = -1;
+        for (int isa = 0; isa < ISA_COUNT; isa++) {
+            if (SDL_strcasecmp(force, variants[isa].name) == 0) forced = isa;
+        }
+
+        if (forced < 0) {
+            print("Unknown kernel variant \"%s\", using %s.\n", force, variants[best].name);
+        } else if (!dispatch_supported(forced)) {
+            print("CPU cannot run %s kernels, using %s.\n", variants[forced].name, variants[best].name);
+        } else {
+            chosen = forced;
+        }
+    }
+
+    dispatch_select(chosen, &kern);
+    print("CPU: SSE2 %d, AVX2 %d, AVX-512F %d, NEON %d.\n",
+        SDL_HasSSE2(), SDL_HasAVX2(), SDL_HasAVX512F(), SDL_HasNEON());
+    print("Using %s kernels%s.\n", kern.name, (chosen != best) ? " (forced)" : "");
+}
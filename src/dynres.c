@@ -0,0 +1,53 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<math.h>
+
+#include<app.h>
+#include<dynres.h>
+
+// Aims for this share of the budget, what is left absorbs frame to frame noise.
+#define DYNRES_HEADROOM 0.9
+// Weight of the newest frame in the smoothed frame time.
+#define DYNRES_SMOOTHING 0.2
+// Share of the way to the ideal scale taken per frame, and the smallest change worth making.
+#define DYNRES_GAIN 0.5
+#define DYNRES_DEADBAND 0.02
+
+void dynres_init(dynres_controller* dr, double budget_ms, double min_scale) {
+    memset(dr, 0, sizeof(dynres_controller));
+    dr->scale = 1.0;
+    dr->budget_ms = budget_ms;
+    dr->min_scale = (min_scale > 0.0 && min_scale <= 1.0) ? min_scale : DYNRES_MIN_SCALE;
+}
+
+double dynres_update(dynres_controller* dr, double frame_ms) {
+    if (dr->budget_ms <= 0.0 || frame_ms <= 0.0) return dr->scale;
+
+    if (dr->smoothed_ms <= 0.0) {
+        dr->smoothed_ms = frame_ms;
+    } else {
+        dr->smoothed_ms += (frame_ms - dr->smoothed_ms) * DYNRES_SMOOTHING;
+    }
+
+    // Not all of a frame scales with its pixels, so this overestimates the change needed.
+    // Only going part of the way there each frame keeps that from overshooting.
+    double ideal = dr->scale * sqrt(dr->budget_ms * DYNRES_HEADROOM / dr->smoothed_ms);
+    ideal = fmin(fmax(ideal, dr->min_scale), 1.0);
+    if (fabs(ideal - dr->scale) > DYNRES_DEADBAND || ideal == 1.0 || ideal == dr->min_scale) {
+        dr->scale += (ideal - dr->scale) * DYNRES_GAIN;
+        // Snaps onto the limits instead of creeping towards them forever.
+        if (fabs(ideal - dr->scale) < DYNRES_DEADBAND / 2) dr->scale = ideal;
+    }
+    return dr->scale;
+}
+
+void dynres_size(double scale, int width, int height, int* out_width, int* out_height) {
+    // Rounded up, so coordinates scaled from inside the window always land inside the target.
+    *out_width = (int)ceil(width * scale);
+    *out_height = (int)ceil(height * scale);
+    if (*out_width < 1) *out_width = 1;
+    if (*out_height < 1) *out_height = 1;
+    if (*out_width > width) *out_width = width;
+    if (*out_height > height) *out_height = height;
+}
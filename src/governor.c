@@ -0,0 +1,107 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<math.h>
+
+#include<app.h>
+#include<governor.h>
+
+// Weight of the newest frame in the smoothed costs and trend.
+#define GOVERNOR_SMOOTHING 0.2
+// Frames ahead the trend is carried out to in the prediction.
+#define GOVERNOR_LOOKAHEAD 4.0
+// Frames after a change before the next one, long enough for the smoothed costs to follow it.
+#define GOVERNOR_SETTLE_FRAMES 10
+// A step is restored once the frame would fit in this share of the budget with it, for
+// GOVERNOR_CALM_FRAMES frames in a row.
+#define GOVERNOR_RECOVER 0.8
+#define GOVERNOR_CALM_FRAMES 60
+// Lowest share of a stage's cost a step is taken to leave, so a stage shed to nothing can still come back.
+#define GOVERNOR_MIN_KEPT 0.05
+
+static const char* step_names[GOV_STEP_COUNT] = {
+    [GOV_NONE] = "none",
+    [GOV_HUD] = "hud",
+    [GOV_LOD] = "lod",
+    [GOV_AMORTIZE] = "amortize"
+};
+
+static const int step_stages[GOV_STEP_COUNT] = {
+    [GOV_NONE] = -1,
+    [GOV_HUD] = GOV_STAGE_HUD,
+    [GOV_LOD] = GOV_STAGE_LINES,
+    [GOV_AMORTIZE] = GOV_STAGE_UPDATE
+};
+
+const char* governor_step_name(enum GovernorStep step) {
+    return (step >= 0 && step < GOV_STEP_COUNT) ? step_names[step] : "unknown";
+}
+
+int governor_step_stage(enum GovernorStep step) {
+    return (step >= 0 && step < GOV_STEP_COUNT) ? step_stages[step] : -1;
+}
+
+void governor_init(frame_governor* gov, double budget_ms) {
+    memset(gov, 0, sizeof(frame_governor));
+    gov->step = GOV_NONE;
+    gov->budget_ms = budget_ms;
+    for (int step = 0; step < GOV_STEP_COUNT; step++) {
+        gov->kept[step] = 1.0;
+    }
+}
+
+int governor_update(frame_governor* gov, double frame_ms, const double* stage_ms, bool may_shed) {
+    if (gov->budget_ms <= 0.0 || frame_ms <= 0.0) return gov->step;
+    gov->frames[gov->step]++;
+
+    if (gov->smoothed_ms <= 0.0) {
+        gov->smoothed_ms = frame_ms;
+        memcpy(gov->stage_ms, stage_ms, sizeof(gov->stage_ms));
+    } else {
+        double previous = gov->smoothed_ms;
+        gov->smoothed_ms += (frame_ms - gov->smoothed_ms) * GOVERNOR_SMOOTHING;
+        gov->trend_ms += (gov->smoothed_ms - previous - gov->trend_ms) * GOVERNOR_SMOOTHING;
+        for (int s = 0; s < GOV_STAGE_COUNT; s++) {
+            gov->stage_ms[s] += (stage_ms[s] - gov->stage_ms[s]) * GOVERNOR_SMOOTHING;
+        }
+    }
+    // Only a rising cost is carried forward, a falling one is left to prove itself.
+    gov->predicted_ms = gov->smoothed_ms + fmax(gov->trend_ms, 0.0) * GOVERNOR_LOOKAHEAD;
+
+    if (gov->settle > 0) {
+        gov->settle--;
+        if (gov->settle == 0 && gov->measuring) {
+            double before = gov->shed_ms[gov->step];
+            double kept = (before > 0.0) ? gov->stage_ms[step_stages[gov->step]] / before : 1.0;
+            gov->kept[gov->step] = fmin(fmax(kept, GOVERNOR_MIN_KEPT), 1.0);
+            gov->measuring = false;
+        }
+        return gov->step;
+    }
+
+    if (gov->predicted_ms > gov->budget_ms) {
+        gov->calm = 0;
+        if (may_shed && gov->step + 1 < GOV_STEP_COUNT) {
+            gov->step++;
+            gov->shed_ms[gov->step] = gov->stage_ms[step_stages[gov->step]];
+            gov->sheds[gov->step]++;
+            gov->settle = GOVERNOR_SETTLE_FRAMES;
+            gov->measuring = true;
+        }
+        return gov->step;
+    }
+
+    if (gov->step > GOV_NONE) {
+        // Scaled from the stage's cost now rather than when it was shed, the load may have changed since.
+        double stage = gov->stage_ms[step_stages[gov->step]];
+        double restored = gov->smoothed_ms + stage * (1.0 / gov->kept[gov->step] - 1.0);
+        gov->calm = (restored < gov->budget_ms * GOVERNOR_RECOVER) ? gov->calm + 1 : 0;
+        if (gov->calm >= GOVERNOR_CALM_FRAMES) {
+            gov->restores[gov->step]++;
+            gov->step--;
+            gov->calm = 0;
+            gov->settle = GOVERNOR_SETTLE_FRAMES;
+        }
+    }
+    return gov->step;
+}
@@ -0,0 +1,134 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<text.h>
+#include<hud.h>
+
+static SDL_Renderer* hud_renderer = NULL;
+static SDL_Texture* layer = NULL;
+static int layer_w = 0;
+static int layer_h = 0;
+
+static char rows[HUD_MAX_ROWS][HUD_ROW_LENGTH];
+static bool dirty[HUD_MAX_ROWS];
+static int row_count = 0;
+static int submitted = 0;
+
+static double min_interval = 0.0;
+static double last_refresh = -1.0;
+static bool invalidated = true;
+
+bool hud_init(SDL_Renderer* renderer, int width, int height) {
+    if (!SDL_RenderTargetSupported(renderer)) {
+        print("Renderer has no render target support.\n");
+        return false;
+    }
+
+    hud_renderer = renderer;
+    layer_w = width;
+    layer_h = height;
+    layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (layer == NULL) return false;
+    SDL_SetTextureBlendMode(layer, SDL_BLENDMODE_BLEND);
+
+    row_count = 0;
+    hud_invalidate();
+    return true;
+}
+
+void hud_destroy() {
+    if (layer != NULL) SDL_DestroyTexture(layer);
+    layer = NULL;
+    hud_renderer = NULL;
+}
+
+void hud_set_max_hz(double hz) {
+    min_interval = (hz > 0.0) ? 1.0 / hz : 0.0;
+}
+
+void hud_invalidate() {
+    invalidated = true;
+    last_refresh = -1.0;
+}
+
+int hud_visible_rows() {
+    int visible = (layer_h + HUD_ROW_HEIGHT - 1) / HUD_ROW_HEIGHT;
+    return (visible < HUD_MAX_ROWS) ? visible : HUD_MAX_ROWS;
+}
+
+bool hud_begin(double now) {
+    if (layer == NULL) return false;
+    if (!invalidated && last_refresh >= 0.0 && now - last_refresh < min_interval) {
+        return false;
+    }
+    last_refresh = now;
+    submitted = 0;
+    return true;
+}
+
+void hud_row(const char* text) {
+    if (submitted >= hud_visible_rows()) return;
+
+    int i = submitted++;
+    if (invalidated || i >= row_count || SDL_strncmp(rows[i], text, HUD_ROW_LENGTH) != 0) {
+        SDL_strlcpy(rows[i], text, HUD_ROW_LENGTH);
+        dirty[i] = true;
+    }
+}
+
+static void clear_row(int i) {
+    SDL_SetRenderDrawColor(hud_renderer, 0, 0, 0, 0);
+    SDL_RenderFillRect(
+        hud_renderer,
+        &(SDL_Rect){.x = 0, .y = i * HUD_ROW_HEIGHT, .w = layer_w, .h = HUD_ROW_HEIGHT}
+    );
+}
+
+void hud_end() {
+    SDL_Color pink = (SDL_Color){.r = 255, .g = 200, .b = 200, .a = 255};
+    SDL_Color black = (SDL_Color){.r = 0, .g = 0, .b = 0, .a = 255};
+
+    bool any = invalidated || submitted < row_count;
+    for (int i = 0; i < submitted && !any; i++) {
+        any = dirty[i];
+    }
+    if (!any) return;
+
+    SDL_Texture* previous = SDL_GetRenderTarget(hud_renderer);
+    SDL_SetRenderTarget(hud_renderer, layer);
+    // Overwrite the stripe including alpha, blending transparent black would be a no-op.
+    SDL_SetRenderDrawBlendMode(hud_renderer, SDL_BLENDMODE_NONE);
+
+    if (invalidated) {
+        SDL_SetRenderDrawColor(hud_renderer, 0, 0, 0, 0);
+        SDL_RenderClear(hud_renderer);
+    }
+    // Rows that disappeared since the last refresh.
+    for (int i = submitted; i < row_count; i++) {
+        clear_row(i);
+    }
+    for (int i = 0; i < submitted; i++) {
+        if (dirty[i] && !invalidated) clear_row(i);
+    }
+
+    SDL_SetRenderDrawBlendMode(hud_renderer, SDL_BLENDMODE_BLEND);
+    for (int i = 0; i < submitted; i++) {
+        if (!dirty[i]) continue;
+        int w = (int)SDL_strlen(rows[i]) * HUD_CHAR_WIDTH;
+        text_draw(rows[i], black, pink, layer_w - w, i * HUD_ROW_HEIGHT, w, HUD_ROW_HEIGHT);
+        dirty[i] = false;
+    }
+    text_flush();
+
+    SDL_SetRenderTarget(hud_renderer, previous);
+    row_count = submitted;
+    invalidated = false;
+}
+
+void hud_composite() {
+    if (layer == NULL) return;
+    SDL_RenderCopy(hud_renderer, layer, NULL, NULL);
+    app->stats.draw_calls++;
+}
@@ -0,0 +1,379 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#include<pthread.h>
+#include<sched.h>
+#endif
+#include<stdio.h>
+#include<stdbool.h>
+#include<assert.h>
+#include<SDL2/SDL.h>
+#ifdef _WIN32
+#include<windows.h>
+#endif
+
+#include<app.h>
+#include<jobs.h>
+
+// Small fork-join pool with work stealing.
+// A parallel loop takes one of a few loop slots and hands each thread an even, contiguous share of
+// its chunks. A thread takes chunks off the front of its own share; once that is empty it cuts the
+// back half off another thread's share and carries on with that, so threads stuck with costlier
+// chunks get helped out. Idle threads sleep until a loop is published and then work through every
+// running loop, so loops started from inside a job (a task graph node, say) spread over the pool
+// too. The caller of a loop returns once the last chunk is done, nothing from one loop leaks into
+// the next that way.
+
+// A share of chunks [next, end), packed into one atomic so popping and stealing are a single CAS each.
+#define SHARE(next, end) ((int)(((Uint32)(next) << 16) | (Uint32)(end)))
+#define SHARE_NEXT(share) ((int)((Uint32)(share) >> 16))
+#define SHARE_END(share) ((int)((Uint32)(share) & 0xFFFF))
+
+enum LoopState {
+    LOOP_FREE = 0,
+    LOOP_CLAIMED,   // Being filled in, or waited out by its caller
+    LOOP_RUNNING,   // Open to every thread
+    LOOP_DRAINING   // Detached and done, freed by the last thread still looking at it
+};
+
+// One per thread, padded out to a cache line so popping never bounces another thread's share around.
+typedef struct job_share {
+    SDL_atomic_t range;
+    char pad[64 - sizeof(SDL_atomic_t)];
+} job_share;
+
+typedef struct job_loop {
+    job_range_fn fn;
+    void* ctx;
+    int count;
+    int chunks;
+    bool detached;              // Nobody waits for it, see jobs_spawn()
+
+    SDL_atomic_t state;         // enum LoopState
+    SDL_atomic_t users;         // Threads looking at the loop, it is not reused before they are gone
+    SDL_atomic_t remaining;     // Chunks not finished yet
+    SDL_sem* done;              // Posted with the last chunk for the waiting caller
+    job_share shares[JOBS_MAX_THREADS + JOBS_MAX_ATTACHED];
+} job_loop;
+
+static SDL_Thread* threads[JOBS_MAX_THREADS];
+static job_loop loops[JOBS_MAX_LOOPS];
+static int thread_count = 1;
+static bool pinned = false;
+static SDL_sem* wake = NULL;
+static SDL_atomic_t sleepers;
+static SDL_atomic_t quitting;
+static SDL_atomic_t steals;
+// Threads outside the pool that called jobs_attach(), they come after the pool's in every share table.
+static SDL_atomic_t attached;
+
+// Pool threads are 1.., attached threads after them, the main thread 0.
+static __thread int current_worker = 0;
+
+// Threads with a share in every loop.
+static int participants() {
+    return thread_count + SDL_AtomicGet(&attached);
+}
+
+void jobs_chunk_range(int count, int chunks, int chunk, int* begin, int* end) {
+    *begin = (int)((long long)count * chunk / chunks);
+    *end = (int)((long long)count * (chunk + 1) / chunks);
+}
+
+int jobs_chunks_for(int count, int grain) {
+    int chunks = (grain > 0) ? count / grain : count;
+    int most = thread_count * JOBS_CHUNKS_PER_THREAD;
+    if (chunks > most) chunks = most;
+    return (chunks < 1) ? 1 : chunks;
+}
+
+// Next chunk off the front of the thread's own share, -1 once it is empty.
+static int pop_chunk(job_loop* loop, int worker) {
+    SDL_atomic_t* range = &loop->shares[worker].range;
+    while (true) {
+        int share = SDL_AtomicGet(range);
+        int next = SHARE_NEXT(share);
+        int end = SHARE_END(share);
+        if (next >= end) return -1;
+        if (SDL_AtomicCAS(range, share, SHARE(next + 1, end))) return next;
+    }
+}
+
+// Moves the back half of some other thread's share, at least one chunk, over to `worker`.
+static bool steal_chunks(job_loop* loop, int worker) {
+    int count = participants();
+    for (int k = 1; k < count; k++) {
+        int victim = (worker + k) % count;
+        SDL_atomic_t* range = &loop->shares[victim].range;
+        while (true) {
+            int share = SDL_AtomicGet(range);
+            int next = SHARE_NEXT(share);
+            int end = SHARE_END(share);
+            if (next >= end) break;
+
+            int split = next + (end - next) / 2;
+            if (SDL_AtomicCAS(range, share, SHARE(next, split))) {
+                // Our share was empty, so nobody else touches it until this lands.
+                SDL_AtomicSet(&loop->shares[worker].range, SHARE(split, end));
+                SDL_AtomicIncRef(&steals);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool has_chunks(job_loop* loop) {
+    for (int i = 0; i < participants(); i++) {
+        int share = SDL_AtomicGet(&loop->shares[i].range);
+        if (SHARE_NEXT(share) < SHARE_END(share)) return true;
+    }
+    return false;
+}
+
+// Runs chunks of the loop until none are left to take, returns whether it ran any.
+static bool run_loop(job_loop* loop, int worker) {
+    bool ran = false;
+    while (true) {
+        int chunk = pop_chunk(loop, worker);
+        if (chunk < 0) {
+            if (!steal_chunks(loop, worker)) break;
+            continue;
+        }
+
+        int begin, end;
+        jobs_chunk_range(loop->count, loop->chunks, chunk, &begin, &end);
+        if (begin < end) loop->fn(loop->ctx, begin, end, worker);
+        ran = true;
+
+        if (SDL_AtomicAdd(&loop->remaining, -1) == 1) {
+            if (loop->detached) {
+                SDL_AtomicSet(&loop->state, LOOP_DRAINING);
+            } else {
+                SDL_SemPost(loop->done);
+            }
+        }
+    }
+    return ran;
+}
+
+static job_loop* claim_loop() {
+    for (int i = 0; i < JOBS_MAX_LOOPS; i++) {
+        if (SDL_AtomicCAS(&loops[i].state, LOOP_FREE, LOOP_CLAIMED)) return &loops[i];
+    }
+    return NULL;
+}
+
+// Opens a filled in loop to every thread and wakes the sleeping ones.
+static void publish_loop(job_loop* loop) {
+    SDL_AtomicSet(&loop->state, LOOP_RUNNING);
+    // Sleepers count themselves before their last look for work, one side always sees the other.
+    int asleep = SDL_AtomicGet(&sleepers);
+    for (int i = 0; i < asleep; i++) {
+        SDL_SemPost(wake);
+    }
+}
+
+static void unref_loop(job_loop* loop) {
+    if (SDL_AtomicAdd(&loop->users, -1) == 1) {
+        SDL_AtomicCAS(&loop->state, LOOP_DRAINING, LOOP_FREE);
+    }
+}
+
+// One pass over every running loop, returns whether any chunk was run.
+static bool help_loops(int worker) {
+    bool ran = false;
+    for (int i = 0; i < JOBS_MAX_LOOPS; i++) {
+        job_loop* loop = &loops[i];
+        if (SDL_AtomicGet(&loop->state) != LOOP_RUNNING) continue;
+
+        SDL_AtomicIncRef(&loop->users);
+        if (SDL_AtomicGet(&loop->state) == LOOP_RUNNING) {
+            ran |= run_loop(loop, worker);
+        }
+        unref_loop(loop);
+    }
+    return ran;
+}
+
+static bool any_work() {
+    for (int i = 0; i < JOBS_MAX_LOOPS; i++) {
+        if (SDL_AtomicGet(&loops[i].state) == LOOP_RUNNING && has_chunks(&loops[i])) return true;
+    }
+    return false;
+}
+
+// Keeps the calling thread on one logical CPU.
+static bool pin_thread(int cpu) {
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+static int worker_main(void* data) {
+    int worker = (int)(intptr_t)data;
+    current_worker = worker;
+    if (pinned && !pin_thread(worker % SDL_GetCPUCount())) {
+        print("Could not pin worker %d.\n", worker);
+    }
+
+    while (!SDL_AtomicGet(&quitting)) {
+        if (help_loops(worker)) continue;
+
+        SDL_AtomicIncRef(&sleepers);
+        if (!any_work() && !SDL_AtomicGet(&quitting)) SDL_SemWait(wake);
+        SDL_AtomicAdd(&sleepers, -1);
+    }
+    return 0;
+}
+
+void jobs_init(int count, bool pin) {
+    if (count <= 0) count = SDL_GetCPUCount();
+    if (count > JOBS_MAX_THREADS) count = JOBS_MAX_THREADS;
+    if (count < 1) count = 1;
+
+    wake = SDL_CreateSemaphore(0);
+    assert(wake != NULL);
+    for (int i = 0; i < JOBS_MAX_LOOPS; i++) {
+        SDL_AtomicSet(&loops[i].state, LOOP_FREE);
+        SDL_AtomicSet(&loops[i].users, 0);
+        loops[i].done = SDL_CreateSemaphore(0);
+        assert(loops[i].done != NULL);
+    }
+    SDL_AtomicSet(&sleepers, 0);
+    SDL_AtomicSet(&quitting, 0);
+    SDL_AtomicSet(&steals, 0);
+    SDL_AtomicSet(&attached, 0);
+
+    thread_count = count;
+    pinned = pin;
+    current_worker = 0;
+    if (pinned && !pin_thread(0)) {
+        print("Could not pin threads on this platform.\n");
+        pinned = false;
+    }
+    for (int i = 1; i < thread_count; i++) {
+        threads[i] = SDL_CreateThread(worker_main, "worker", (void*)(intptr_t)i);
+        assert(threads[i] != NULL);
+    }
+    print("Running jobs on %d thread(s)%s.\n", thread_count, pinned ? ", pinned" : "");
+}
+
+void jobs_shutdown() {
+    if (wake == NULL) return;
+
+    // Detached jobs still queued are run here rather than dropped.
+    while (help_loops(current_worker));
+
+    SDL_AtomicSet(&quitting, 1);
+    for (int i = 1; i < thread_count; i++) {
+        SDL_SemPost(wake);
+    }
+    for (int i = 1; i < thread_count; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    for (int i = 0; i < JOBS_MAX_LOOPS; i++) {
+        SDL_DestroySemaphore(loops[i].done);
+        loops[i].done = NULL;
+    }
+    SDL_DestroySemaphore(wake);
+    wake = NULL;
+    thread_count = 1;
+    pinned = false;
+}
+
+int jobs_thread_count() {
+    return thread_count;
+}
+
+int jobs_current_worker() {
+    return current_worker;
+}
+
+void jobs_attach() {
+    int k = SDL_AtomicAdd(&attached, 1);
+    assert(k < JOBS_MAX_ATTACHED);
+    current_worker = thread_count + k;
+}
+
+bool jobs_pinned() {
+    return pinned;
+}
+
+int jobs_steal_count() {
+    return SDL_AtomicGet(&steals);
+}
+
+static void run_inline(int count, int chunks, job_range_fn fn, void* ctx) {
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        int begin, end;
+        jobs_chunk_range(count, chunks, chunk, &begin, &end);
+        if (begin < end) fn(ctx, begin, end, current_worker);
+    }
+}
+
+static void fill_loop(job_loop* loop, int count, int chunks, job_range_fn fn, void* ctx, bool detached) {
+    loop->fn = fn;
+    loop->ctx = ctx;
+    loop->count = count;
+    loop->chunks = chunks;
+    loop->detached = detached;
+    SDL_AtomicSet(&loop->remaining, chunks);
+}
+
+void jobs_parallel_for(int count, int chunks, job_range_fn fn, void* ctx) {
+    if (count <= 0 || chunks <= 0) return;
+    assert(chunks <= JOBS_MAX_CHUNKS);
+
+    // A single chunk or no pool: no reason to wake anyone.
+    // With every loop slot taken the pool is busy enough as it is.
+    job_loop* loop = (thread_count > 1 && chunks > 1) ? claim_loop() : NULL;
+    if (loop == NULL) {
+        run_inline(count, chunks, fn, ctx);
+        return;
+    }
+
+    // Pool threads get the chunks, attached callers start out stealing.
+    fill_loop(loop, count, chunks, fn, ctx, false);
+    for (int i = 0; i < participants(); i++) {
+        int begin = 0, end = 0;
+        if (i < thread_count) jobs_chunk_range(chunks, thread_count, i, &begin, &end);
+        SDL_AtomicSet(&loop->shares[i].range, SHARE(begin, end));
+    }
+    publish_loop(loop);
+
+    run_loop(loop, current_worker);
+    SDL_SemWait(loop->done);
+
+    // Threads that found the loop empty may still be looking at it.
+    SDL_AtomicSet(&loop->state, LOOP_CLAIMED);
+    while (SDL_AtomicGet(&loop->users) > 0) {
+        SDL_CPUPauseInstruction();
+    }
+    SDL_AtomicSet(&loop->state, LOOP_FREE);
+}
+
+void jobs_spawn(job_range_fn fn, void* ctx) {
+    job_loop* loop = claim_loop();
+    if (loop == NULL) {
+        fn(ctx, 0, 1, current_worker);
+        return;
+    }
+
+    // Queued on the spawning thread's share, where it stays unless someone idle steals it.
+    fill_loop(loop, 1, 1, fn, ctx, true);
+    for (int i = 0; i < participants(); i++) {
+        SDL_AtomicSet(&loop->shares[i].range, SHARE(0, (i == current_worker) ? 1 : 0));
+    }
+    publish_loop(loop);
+}
+
+bool jobs_help() {
+    return help_loops(current_worker);
+}
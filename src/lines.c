@@ -0,0 +1,134 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<assert.h>
+#include<malloc.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<lines.h>
+#include<raster.h>
+#include<dispatch.h>
+
+static const SDL_Color colors[LINE_COLOR_COUNT] = {
+    [LINE_FRONT] = {.r = 255, .g = 0, .b = 0, .a = 255},
+    [LINE_BACK] = {.r = 0, .g = 255, .b = 0, .a = 255},
+    [LINE_CONNECT] = {.r = 0, .g = 0, .b = 255, .a = 255},
+};
+
+typedef struct seg_buffer {
+    line_seg* segs;
+    int count;
+    int capacity;
+} seg_buffer;
+
+static seg_buffer buffers[LINE_COLOR_COUNT];
+
+// Geometry scratch, only ever grows so steady state frames do not allocate.
+static SDL_Vertex* vertices = NULL;
+static int* indices = NULL;
+static int quad_capacity = 0;
+
+void lines_begin() {
+    for (int c = 0; c < LINE_COLOR_COUNT; c++) {
+        buffers[c].count = 0;
+    }
+}
+
+void lines_push(enum LineColor color, float x1, float y1, float x2, float y2) {
+    seg_buffer* b = &buffers[color];
+    if (b->count == b->capacity) {
+        b->capacity = (b->capacity > 0) ? b->capacity * 2 : 256;
+        b->segs = realloc(b->segs, sizeof(line_seg) * b->capacity);
+        assert(b->segs != NULL);
+    }
+    b->segs[b->count++] = (line_seg){.x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2};
+}
+
+int lines_count() {
+    int total = 0;
+    for (int c = 0; c < LINE_COLOR_COUNT; c++) {
+        total += buffers[c].count;
+    }
+    return total;
+}
+
+const line_seg* lines_segments(enum LineColor color, int* count) {
+    *count = buffers[color].count;
+    return buffers[color].segs;
+}
+
+Uint32 lines_color_argb(enum LineColor color) {
+    SDL_Color c = colors[color];
+    return ((Uint32)c.a << 24) | ((Uint32)c.r << 16) | ((Uint32)c.g << 8) | c.b;
+}
+
+static void reserve_quads(int quads) {
+    if (quads <= quad_capacity) return;
+
+    int grown = (quad_capacity > 0) ? quad_capacity : 256;
+    while (grown < quads) grown *= 2;
+    vertices = realloc(vertices, sizeof(SDL_Vertex) * 4 * grown);
+    indices = realloc(indices, sizeof(int) * 6 * grown);
+    assert(vertices != NULL && indices != NULL);
+
+    // Index pattern never changes, only the new tail needs filling.
+    for (int q = quad_capacity; q < grown; q++) {
+        indices[q * 6 + 0] = q * 4 + 0;
+        indices[q * 6 + 1] = q * 4 + 1;
+        indices[q * 6 + 2] = q * 4 + 2;
+        indices[q * 6 + 3] = q * 4 + 2;
+        indices[q * 6 + 4] = q * 4 + 3;
+        indices[q * 6 + 5] = q * 4 + 0;
+    }
+    quad_capacity = grown;
+}
+
+void line_quad(SDL_Vertex* v, line_seg s, SDL_Color color) {
+    float ax = s.x1 + 0.5f, ay = s.y1 + 0.5f;
+    float bx = s.x2 + 0.5f, by = s.y2 + 0.5f;
+    float dx = bx - ax, dy = by - ay;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len > 0.0f) {
+        dx = dx / len * 0.5f;
+        dy = dy / len * 0.5f;
+    } else {
+        // Single pixel.
+        dx = 0.5f;
+        dy = 0.0f;
+    }
+
+    v[0] = (SDL_Vertex){.position = {ax - dx - dy, ay - dy + dx}, .color = color};
+    v[1] = (SDL_Vertex){.position = {bx + dx - dy, by + dy + dx}, .color = color};
+    v[2] = (SDL_Vertex){.position = {bx + dx + dy, by + dy - dx}, .color = color};
+    v[3] = (SDL_Vertex){.position = {ax - dx + dy, ay - dy - dx}, .color = color};
+}
+
+int lines_flush(SDL_Renderer* renderer) {
+    int draw_calls = 0;
+    for (int c = 0; c < LINE_COLOR_COUNT; c++) {
+        seg_buffer* b = &buffers[c];
+        if (b->count == 0) continue;
+
+        reserve_quads(b->count);
+        for (int i = 0; i < b->count; i++) {
+            line_quad(&vertices[i * 4], b->segs[i], colors[c]);
+        }
+        SDL_RenderGeometry(renderer, NULL, vertices, b->count * 4, indices, b->count * 6);
+        draw_calls++;
+    }
+    return draw_calls;
+}
+
+int lines_flush_soft(framebuffer* fb) {
+    SDL_Rect all = {.x = 0, .y = 0, .w = fb->width, .h = fb->height};
+    for (int c = 0; c < LINE_COLOR_COUNT; c++) {
+        seg_buffer* b = &buffers[c];
+        Uint32 argb = lines_color_argb(c);
+        for (int i = 0; i < b->count; i++) {
+            line_seg s = b->segs[i];
+            kern.raster_line(fb, (int)s.x1, (int)s.y1, (int)s.x2, (int)s.y2, argb, all);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<assert.h>
+#include<malloc.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<lockfree.h>
+
+void triple_init(triple_buffer* tb) {
+    tb->back = 0;
+    SDL_AtomicSet(&tb->middle, 1);
+    tb->front = 2;
+}
+
+int triple_publish(triple_buffer* tb) {
+    // The writer gets back whatever was in between, taken by the reader or not.
+    int previous = SDL_AtomicSet(&tb->middle, tb->back | TRIPLE_FRESH);
+    tb->back = previous & ~TRIPLE_FRESH;
+    return tb->back;
+}
+
+int triple_acquire(triple_buffer* tb) {
+    if (SDL_AtomicGet(&tb->middle) & TRIPLE_FRESH) {
+        // Should the writer publish again in between, the swap simply takes the newer slot.
+        int previous = SDL_AtomicSet(&tb->middle, tb->front);
+        tb->front = previous & ~TRIPLE_FRESH;
+    }
+    return tb->front;
+}
+
+bool triple_fresh(triple_buffer* tb) {
+    return (SDL_AtomicGet(&tb->middle) & TRIPLE_FRESH) != 0;
+}
+
+bool spsc_init(spsc_queue* q, int item_size, int capacity) {
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    q->items = malloc((size_t)item_size * capacity);
+    q->item_size = item_size;
+    q->capacity = capacity;
+    SDL_AtomicSet(&q->head, 0);
+    SDL_AtomicSet(&q->tail, 0);
+    return q->items != NULL;
+}
+
+void spsc_destroy(spsc_queue* q) {
+    free(q->items);
+    q->items = NULL;
+}
+
+bool spsc_push(spsc_queue* q, const void* item) {
+    int tail = SDL_AtomicGet(&q->tail);
+    if ((Uint32)tail - (Uint32)SDL_AtomicGet(&q->head) == (Uint32)q->capacity) return false;
+
+    memcpy(&q->items[(size_t)(tail & (q->capacity - 1)) * q->item_size], item, q->item_size);
+    // Publishing the new tail after the copy is what makes the item visible.
+    SDL_AtomicSet(&q->tail, (int)((Uint32)tail + 1));
+    return true;
+}
+
+bool spsc_pop(spsc_queue* q, void* item) {
+    int head = SDL_AtomicGet(&q->head);
+    if (head == SDL_AtomicGet(&q->tail)) return false;
+
+    memcpy(item, &q->items[(size_t)(head & (q->capacity - 1)) * q->item_size], q->item_size);
+    SDL_AtomicSet(&q->head, (int)((Uint32)head + 1));
+    return true;
+}
@@ -6,159 +6,101 @@
 #include<SDL2/SDL.h>
 
 #include<app.h>
+#include<pool.h>
+#include<text.h>
+#include<hud.h>
+#include<xform.h>
+#include<dispatch.h>
+#include<autorot.h>
+#include<trig.h>
+#include<lines.h>
+#include<mesh.h>
+#include<clip.h>
+#include<bvh.h>
+#include<jobs.h>
+#include<morton.h>
+#include<raster.h>
+#include<tiler.h>
+#include<taskgraph.h>
+#include<sim.h>
+#include<pacer.h>
+#include<dynres.h>
+#include<governor.h>
+#include<bench.h>
 
 app_t* app;
 
 const double RAD_TO_DEG = 180 / 3.1415;
 
-void render_text(char* text, SDL_Color fg, SDL_Color bg, int x, int y, int w, int h) {
-    SDL_Surface* surf = TTF_RenderText(
-        app->font,
-        text,
-        fg,
-        bg
-    );
-    SDL_Texture* tex = SDL_CreateTextureFromSurface(app->renderer, surf);
-    SDL_RenderCopy(
-        app->renderer, 
-        tex, 
-        NULL, 
-        &(SDL_Rect){
-            .x = x,
-            .y = y,
-            .w = w,
-            .h = h
-        }
-    );
-    SDL_DestroyTexture(tex);
-    SDL_FreeSurface(surf);
-}
-
-typedef struct v3 {
-    double x;
-    double y;
-    double z;
-} v3;
-
-v3 v_add(v3 a, v3 b) {
-    return (v3){
-        .x = a.x + b.x,
-        .y = a.y + b.y,
-        .z = a.z + b.z
-    };
-}
-
-v3 v_min(v3 a, v3 b) {
-    return (v3){
-        .x = a.x - b.x,
-        .y = a.y - b.y,
-        .z = a.z - b.z
-    };
-}
-
-// Rotations
-// NOTE: This is all unoptimized, but I don't care, I simply want to code.
-// Consider precomputing sines and cosines beforehand then multiplying respective coordinations.
-// https://en.wikipedia.org/wiki/Rotation_matrix
-v3 v_rotate_x(v3 a, double angle) {
-    // [1 0          0          ][x]   [x]
-    // [0 cos(theta) -sin(theta)][y] = [y * cos(theta) - z * sin(theta)]
-    // [0 sin(theta) cos(theta) ][z] = [y * sin(theta) + z * cos(theta)]
-
-    double s = sin(angle);
-    double c = cos(angle);
-
-    return (v3){
-        .x = a.x,
-        .y = a.y * c - a.z * s,
-        .z = a.y * s + a.z * c
-    };
-}
-
-v3 v_rotate_y(v3 a, double angle) {
-    // [cos(theta) 0 -sin(theta)][x]   [x * cos(theta) - z * sin(theta)]
-    // [0          1 0          ][y] = [y]
-    // [sin(theta) 0 cos(theta) ][z]   [x * sin(theta) + z * cos(theta)]
-
-    double s = sin(angle);
-    double c = cos(angle);
-
-    return (v3){
-        .x = a.x * c - a.z * s,
-        .y = a.y,
-        .z = a.x * s + a.z * c
-    };
-}
-
-v3 v_rotate_z(v3 a, double angle) {
-    // [cos(theta) -sin(theta) 0][x]   [x * cos(theta) - y * sin(theta)]
-    // [sin(theta) cos(theta)  0][y] = [x * sin(theta) + y * cos(theta)]
-    // [0          0           1][z]   [z]
-
-    double s = sin(angle);
-    double c = cos(angle);
-
-    return (v3){
-        .x = a.x * c - a.y * s,
-        .y = a.x * s + a.y * c,
-        .z = a.z
-    };
-}
-
-v3 v_rotate(v3 a, double rot_x, double rot_y, double rot_z) {
-    return v_rotate_z(
-        v_rotate_y(
-            v_rotate_x(a, rot_x),
-            rot_y
-        ),
-        rot_z
-    );
-}
+// What the renderer draws, mirrored from the simulation's snapshots every frame.
+cube_pool scene;
+
+// Every vertex of every cube's mesh, transformed and projected at the start of each frame.
+vertex_cache vcache;
+// Over the scene's cube bounds, refit every frame, rebuilt when cubes come and go.
+bvh scene_bvh;
+// Z-order of the scene's storage, only kept up when --morton is given.
+morton_order scene_order;
+// CPU side target of the software backend.
+framebuffer soft_fb;
+// Decides when the next frame starts.
+frame_pacer pacer;
+// Picks the scale the scene is drawn at with --dynamic-res.
+dynres_controller dynres;
+// Offscreen target the SDL backend draws the scene into below full scale, window sized.
+SDL_Texture* scene_target = NULL;
+// Sheds work when frames are about to run over budget, with --governor.
+frame_governor governor;
+
+// On-demand rendering and throttling, see frame_wanted().
+Uint32 snapshot_event = 0;  // Pushed by the simulation whenever it publishes
+bool redraw_pending = true; // An event changed something only a new frame shows
+bool hud_stale = false;     // The HUD skipped a refresh, throttled by --hud-hz
+bool window_hidden = false;
+bool window_focused = true;
+int frames_drawn = 0;
+int idle_wakeups = 0;
+
+// State the tasks of a frame share.
+typedef struct frame_ctx {
+    task_graph graph;
+    const scene_snapshot* snap;
+    double alpha;   // How far between the two newest snapshots the frame is drawn
+    int blended;    // Cubes sim_blend() wrote, frames keep coming while any are in motion
+    double scale;   // Of the window's width and height the scene is drawn at
+    int target_w;
+    int target_h;
+    int shed;       // enum GovernorStep, the last step of work the governor has this frame go without
+    frustum view;
+} frame_ctx;
+
+enum SimCommandType {
+    CMD_ROTATE,         // Adds value to the selected cube's rotation
+    CMD_SELECT,         // Moves the selection by step cubes
+    CMD_TOGGLE_AUTOROT
+};
 
-typedef struct cube {
-    v3 ftl;
-    v3 ftr;
-    v3 fbl;
-    v3 fbr;
-
-    v3 btl;
-    v3 btr;
-    v3 bbl;
-    v3 bbr;
-
-    v3 center;
-    double x_rot;
-    double y_rot;
-    double z_rot;
-
-    bool auto_rot;
-    double auto_x_rot;
-    double auto_y_rot;
-    double auto_z_rot;
-} cube;
-
-cube cubes[2];
-
-void connect_lines(v3 a, v3 b) {
-    double fov = app->fov;
-
-    double apx = a.x * fov / (fov + a.z);
-    double apy = a.y * fov / (fov + a.z);
-    
-    double bpx = b.x * fov / (fov + b.z);
-    double bpy = b.y * fov / (fov + b.z);
-
-    int x1 = (int)apx;
-    int y1 = (int)apy;
-    int x2 = (int)bpx;
-    int y2 = (int)bpy;
-
-    SDL_RenderDrawLine(
-        app->renderer,
-        x1,
-        y1,
-        x2,
-        y2
+frame_ctx frame;
+
+// Frames --trace records before the file is closed.
+#define TRACE_FRAMES 120
+// Frame rate an unfocused window is held to.
+#define BACKGROUND_FPS 10.0
+// Longest a waiting main loop sleeps without any event. The simulation wakes it when cubes move.
+#define IDLE_TIMEOUT_MS 500
+// Default simulation rate. Toggling auto-rotation spins a cube by its current angles every tick at
+// this rate, whatever rate the simulation actually runs at.
+#define SIM_HZ 50.0
+
+void connect_lines(enum LineColor color, const line_seg* seg) {
+    // Snapped to whole pixels of the scene target like the SDL_RenderDrawLine calls this batches up.
+    double scale = frame.scale;
+    lines_push(
+        color,
+        (float)(int)(seg->x1 * scale),
+        (float)(int)(seg->y1 * scale),
+        (float)(int)(seg->x2 * scale),
+        (float)(int)(seg->y2 * scale)
     );
 }
 
@@ -171,131 +113,257 @@ char* editing_texts[6] = {
     "Toggle autorotation"
 };
 
+// Set by render_infos() when it formatted rows that hud_end() still has to draw.
+bool hud_pending = false;
+
+// Rows shown instead of the cubes' while D is on, most of them change every frame.
+void render_diagnostics(char* to_render, size_t size, const char* shed_steps) {
+    #define rd_text() hud_row(to_render)
+
+    snprintf(to_render, size, "Sim: tick %llu, %.2f s at %.1f of %g Hz, blend %.2f",
+        (unsigned long long)frame.snap->tick, frame.snap->time, 1.0 / frame.snap->dt, app->sim_hz, frame.alpha);
+    rd_text();
+    snprintf(to_render, size, "Sim time dropped: %.2f s", frame.snap->dropped);
+    rd_text();
+    snprintf(to_render, size, "Kernels: %s, threads: %i%s", kern.name, jobs_thread_count(), jobs_pinned() ? " (pinned)" : "");
+    rd_text();
+    snprintf(to_render, size, "Draw calls: %i, lines: %i", app->last_stats.draw_calls, app->last_stats.lines);
+    rd_text();
+    snprintf(to_render, size, "Culled: %i cubes, clipped: %i, rejected: %i edges",
+        app->last_stats.cubes_culled, app->last_stats.edges_clipped, app->last_stats.edges_rejected);
+    rd_text();
+    snprintf(to_render, size, "Frame graph: %.2f ms, critical path %.2f ms",
+        app->last_stats.graph_ms, app->last_stats.critical_ms);
+    rd_text();
+    snprintf(to_render, size, "Pacing: %s at %g Hz, frame %.2f ms, slept %.2f, spun %.2f",
+        pace_mode_name(pacer.mode), pacer.target_hz, pacer.frame_ms, pacer.sleep_ms, pacer.spin_ms);
+    rd_text();
+    snprintf(to_render, size, "Rendering: %s (O), %i frames, %i idle wake-ups",
+        app->on_demand ? "on demand" : "continuous", frames_drawn, idle_wakeups);
+    rd_text();
+    snprintf(to_render, size, "Render scale: %.2f, %ix%i, budget %.1f ms, work %.2f ms",
+        frame.scale, frame.target_w, frame.target_h, dynres.budget_ms, app->last_stats.work_ms);
+    rd_text();
+    snprintf(to_render, size, "Governor: shedding %s, predicted %.2f ms", shed_steps, governor.predicted_ms);
+    rd_text();
+    snprintf(to_render, size, "Shed: %i outlined, %i deferred, times hud %i, lod %i, amortize %i",
+        app->last_stats.cubes_outlined, app->last_stats.blends_owed,
+        governor.sheds[GOV_HUD], governor.sheds[GOV_LOD], governor.sheds[GOV_AMORTIZE]);
+    rd_text();
+    snprintf(to_render, size, "Stages: hud %.2f ms, lines %.2f ms, update %.2f ms",
+        governor.stage_ms[GOV_STAGE_HUD], governor.stage_ms[GOV_STAGE_LINES], governor.stage_ms[GOV_STAGE_UPDATE]);
+    rd_text();
+}
+
+// Formats the HUD rows without touching the renderer, so it can run on any thread.
 void render_infos() {
-    char to_render[100];
-    SDL_Color pink = (SDL_Color){.r = 255, .g = 200, .b = 200, .a = 255};
-    SDL_Color black = (SDL_Color){.r = 0, .g = 0, .b = 0, .a = 255};
+    // Rows are diffed against the retained layer, only changed ones get redrawn.
+    hud_pending = hud_begin(pacer_now());
+    if (!hud_pending) return;
+
+    char to_render[HUD_ROW_LENGTH];
     int text_row = 0;
 
     #define ri_text() \
-        render_text( \
-            to_render, \
-            black, pink, \
-            app->screen_width - SDL_strlen(to_render) * 10, (text_row++) * 30, \
-            SDL_strlen(to_render) * 10, 30)
+        hud_row(to_render); \
+        text_row++
 
-    sprintf(to_render, "FOV: %i", (int)app->fov);
+    snprintf(to_render, sizeof to_render, "FOV: %i", (int)app->fov);
+    ri_text();
+    snprintf(to_render, sizeof to_render, "Current cube: %i\n", frame.snap->selected);
     ri_text();
-    sprintf(to_render, "Current cube: %i\n", app->current_cube);
+    snprintf(to_render, sizeof to_render, "%s (+/-)", editing_texts[app->em]);
     ri_text();
-    sprintf(to_render, "%s (+/-)", editing_texts[app->em]);
+
+    char shed_steps[32] = "nothing";
+    for (int step = GOV_HUD; step <= app->last_stats.shed; step++) {
+        if (step == GOV_HUD) {
+            SDL_strlcpy(shed_steps, governor_step_name(step), sizeof(shed_steps));
+        } else {
+            SDL_strlcat(shed_steps, ", ", sizeof(shed_steps));
+            SDL_strlcat(shed_steps, governor_step_name(step), sizeof(shed_steps));
+        }
+    }
+    // Only settings here, so the row stays put from one frame to the next.
+    snprintf(to_render, sizeof to_render, "%s (B), %s (P), %s (R), shed: %s (G), more (D)",
+        backend_name(app->backend), pace_mode_name(pacer.mode), app->dynamic_res ? "dynamic" : "fixed",
+        app->governor ? shed_steps : "off");
     ri_text();
 
-    for (int i = 0; i < app->cube_count; i++) {
-        sprintf(to_render, "Cube %i           ", i);
+    if (app->diagnostics) {
+        render_diagnostics(to_render, sizeof to_render, shed_steps);
+        return;
+    }
+
+    // Rows below the bottom of the window are never formatted.
+    for (int i = 0; i < scene.count && text_row < hud_visible_rows(); i++) {
+        snprintf(to_render, sizeof to_render, "Cube %i           ", i);
         ri_text();
 
-        cube cub = cubes[i];
+        v3 center = scene.center[i];
+        v3 extent = scene.extent[i];
+        v3 rot = scene.rot[i];
 
-        sprintf(to_render, "  - x: %i w: %i", (int)cub.ftl.x, (int)(cub.ftr.x - cub.ftl.x));
+        snprintf(to_render, sizeof to_render, "  - x: %i w: %i", (int)(center.x - extent.x), (int)(extent.x * 2));
         ri_text();
-        sprintf(to_render, "  - y: %i h: %i", (int)cub.ftl.y, (int)(cub.ftl.y - cub.btl.y));
+        snprintf(to_render, sizeof to_render, "  - y: %i h: %i", (int)(center.y - extent.y), (int)(extent.y * 2));
         ri_text();
-        sprintf(to_render, "  - z: %i d: %i", (int)cub.ftl.z, (int)(cub.btl.z - cub.ftl.z));
+        snprintf(to_render, sizeof to_render, "  - z: %i d: %i", (int)(center.z - extent.z), (int)(extent.z * 2));
         ri_text();
-        sprintf(to_render, "   - rx: %i", (int)(cub.x_rot * RAD_TO_DEG));
+        snprintf(to_render, sizeof to_render, "   - rx: %i", (int)(rot.x * RAD_TO_DEG));
         ri_text();
-        sprintf(to_render, "   - ry: %i", (int)(cub.y_rot * RAD_TO_DEG));
+        snprintf(to_render, sizeof to_render, "   - ry: %i", (int)(rot.y * RAD_TO_DEG));
         ri_text();
-        sprintf(to_render, "   - rz: %i", (int)(cub.z_rot * RAD_TO_DEG));
+        snprintf(to_render, sizeof to_render, "   - rz: %i", (int)(rot.z * RAD_TO_DEG));
         ri_text();
         
     }
 }
 
-void render_cube(cube cub) {
+// Draws a cube entirely in view as the rectangle around its projected vertices, if it is small
+// enough on screen for that to hardly show. Returns whether it did.
+bool render_cube_outline(const wire_mesh* mesh, const float* xs, const float* ys) {
+    float min_x = xs[0], max_x = xs[0];
+    float min_y = ys[0], max_y = ys[0];
+    for (int v = 1; v < mesh->vertex_count; v++) {
+        min_x = fminf(min_x, xs[v]);
+        max_x = fmaxf(max_x, xs[v]);
+        min_y = fminf(min_y, ys[v]);
+        max_y = fmaxf(max_y, ys[v]);
+    }
+    if (max_x - min_x >= GOVERNOR_LOD_PIXELS || max_y - min_y >= GOVERNOR_LOD_PIXELS) return false;
+
+    line_seg outline[4] = {
+        {.x1 = min_x, .y1 = min_y, .x2 = max_x, .y2 = min_y},
+        {.x1 = max_x, .y1 = min_y, .x2 = max_x, .y2 = max_y},
+        {.x1 = max_x, .y1 = max_y, .x2 = min_x, .y2 = max_y},
+        {.x1 = min_x, .y1 = max_y, .x2 = min_x, .y2 = min_y}
+    };
+    for (int k = 0; k < 4; k++) {
+        connect_lines(LINE_FRONT, &outline[k]);
+    }
+    return true;
+}
+
+void render_cube(int i, const frustum* view, bool lod) {
     // TODO: Depending on how cube is aligned, we shouldn't be using z.
     // Example: rotating the cube by Y axis moves the Z axis away
     // Hence rendering something else.
 
+    enum CullResult cull = vcache.visible[i];
+    if (cull == CULL_OUTSIDE) return;
 
-    #define do_things(v) v_add(v_rotate(v_min(v, cub.center), cub.x_rot, cub.y_rot, cub.z_rot), cub.center);
-
-    v3 ftl = do_things(cub.ftl);
-    v3 ftr = do_things(cub.ftr);
-    v3 fbl = do_things(cub.fbl);
-    v3 fbr = do_things(cub.fbr);
-    v3 btl = do_things(cub.btl);
-    v3 btr = do_things(cub.btr);
-    v3 bbl = do_things(cub.bbl);
-    v3 bbr = do_things(cub.bbr);
-
-    // "Front" cube
-    SDL_SetRenderDrawColor(app->renderer, 255, 0, 0, 255);
-    connect_lines(ftl, ftr); // Top horizontal
-    connect_lines(ftr, fbr); // Right vertical
-    connect_lines(fbr, fbl); // Bottom horizontal
-    connect_lines(fbl, ftl); // Left vertical
-
-    // "Back" cube
-    SDL_SetRenderDrawColor(app->renderer, 0, 255, 0, 255);
-    connect_lines(btl, btr); // Top horizontal
-    connect_lines(btr, bbr); // Right vertical
-    connect_lines(bbr, bbl); // Bottom horizontal
-    connect_lines(bbl, btl); // Left vertical       
-
-    // Connections between both cubes
-    SDL_SetRenderDrawColor(app->renderer, 0, 0, 255, 255);
-    connect_lines(ftl, btl); // Top left
-    connect_lines(ftr, btr); // Top left
-    connect_lines(fbl, bbl); // Top left
-    connect_lines(fbr, bbr); // Top left
-}
-
-void game_render() {
-    SDL_SetRenderDrawColor(app->renderer, 255, 200, 200, 255);
-    SDL_RenderClear(app->renderer);
-
-    SDL_SetRenderDrawColor(app->renderer, 0, 0, 0, 255);
-    for (int i = 0; i < app->cube_count; i++) {
-        cube cub = cubes[i];
-        render_cube(cub);        
-    }
+    const wire_mesh* mesh = scene.mesh[i];
+    int base = vcache.base[i];
+    const float* xs = &vcache.proj_x[base];
+    const float* ys = &vcache.proj_y[base];
 
-    render_infos();
+    // Cubes needing clipping are left whole, their outline could reach past the screen's edges.
+    if (lod && cull == CULL_INSIDE && render_cube_outline(mesh, xs, ys)) {
+        app->stats.cubes_outlined++;
+        return;
+    }
 
-    SDL_RenderPresent(app->renderer);
+    for (int e = 0; e < mesh->edge_count; e++) {
+        const mesh_edge* edge = &mesh->edges[e];
+        int a = edge->a;
+        int b = edge->b;
+        line_seg seg = {.x1 = xs[a], .y1 = ys[a], .x2 = xs[b], .y2 = ys[b]};
+
+        // Cubes entirely in view skip clipping altogether.
+        if (cull == CULL_INTERSECT) {
+            v3 wa = {.x = vcache.world_x[base + a], .y = vcache.world_y[base + a], .z = vcache.world_z[base + a]};
+            v3 wb = {.x = vcache.world_x[base + b], .y = vcache.world_y[base + b], .z = vcache.world_z[base + b]};
+            enum ClipResult clip = clip_edge(view, wa, wb, xs[a], ys[a], xs[b], ys[b], &seg);
+            if (clip == CLIP_REJECTED) {
+                app->stats.edges_rejected++;
+                continue;
+            }
+            if (clip == CLIP_CLIPPED) app->stats.edges_clipped++;
+        }
+        connect_lines(edge->color, &seg);
+    }
 }
 
-void create_cube(
-    int i, 
+cube_handle create_cube(
     double x, double y, double z, 
     double width, double height, double depth
 ) {
-    cube* cub = &cubes[i];
-    // Front
-    cub->ftl = (v3){.x = x        , .y = y         , .z = z        };
-    cub->ftr = (v3){.x = x + width, .y = y         , .z = z        };
-    cub->fbl = (v3){.x = x        , .y = y + height, .z = z        };
-    cub->fbr = (v3){.x = x + width, .y = y + height, .z = z        };
-    // Back
-    cub->btl = (v3){.x = x        , .y = y         , .z = z + depth};
-    cub->btr = (v3){.x = x + width, .y = y         , .z = z + depth};
-    cub->bbl = (v3){.x = x        , .y = y + height, .z = z + depth};
-    cub->bbr = (v3){.x = x + width, .y = y + height, .z = z + depth};
-
-    cub->center = (v3){
+    cube_pool* pool = sim_pool();
+    int i;
+    cube_handle handle = pool_add(pool, &i);
+
+    pool->center[i] = (v3){
         .x = x + (width / 2),
         .y = y + (height / 2),
         .z = z + (depth / 2)
     };
+    pool->extent[i] = (v3){
+        .x = width / 2,
+        .y = height / 2,
+        .z = depth / 2
+    };
 
-    cub->auto_rot = false;
-    cub->x_rot = cub->auto_x_rot = 0;
-    cub->y_rot = cub->auto_y_rot = 0;
-    cub->z_rot = cub->auto_z_rot = 0;
+    pool->auto_rot[i] = false;
+    pool_set_rot(pool, i, (v3){.x = 0, .y = 0, .z = 0});
+
+    return handle;
 }
 
+// Lays `count` small cubes out in screen-sized layers receding along z.
+void create_cube_grid(int count) {
+    const double size = 20.0;
+    const double spacing = 30.0;
+    int columns = (int)(app->screen_width / spacing);
+    int rows = (int)(app->screen_height / spacing);
+    int per_layer = columns * rows;
+
+    for (int i = 0; i < count; i++) {
+        int layer = i / per_layer;
+        int in_layer = i % per_layer;
+        create_cube(
+            (in_layer % columns) * spacing + (spacing - size) / 2,
+            (in_layer / columns) * spacing + (spacing - size) / 2,
+            layer * spacing,
+            size, size, size
+        );
+    }
+}
+
+
+// Vsync is a property of the renderer, SDL_RenderSetVSync() switches it while running.
+void set_pace_mode(enum PaceMode mode) {
+    if (SDL_RenderSetVSync(app->renderer, mode == PACE_VSYNC) != 0) {
+        print("Could not switch vsync: %s\n", SDL_GetError());
+        if (mode == PACE_VSYNC) mode = PACE_TIMER;
+    }
+    pacer_set_mode(&pacer, mode);
+    print("Pacing frames with %s.\n", pace_mode_name(mode));
+}
+
+// How long a task took in the last run.
+double task_ms(const task_graph* g, int id) {
+    const task* t = &g->tasks[id];
+    return (double)(t->end - t->start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// Makes the next frames go without the governor's steps up to `step`, and restores the ones past it.
+void set_shed_step(frame_ctx* frame, int step) {
+    if (step == frame->shed) return;
+    if (step > frame->shed) {
+        print("Predicted %.2f ms of a %.1f ms budget, shedding %s.\n",
+            governor.predicted_ms, governor.budget_ms, governor_step_name(step));
+    } else {
+        for (int restored = frame->shed; restored > step; restored--) {
+            print("Restoring %s.\n", governor_step_name(restored));
+        }
+    }
+
+    double hud_hz = app->hud_max_hz;
+    if (step >= GOV_HUD && (hud_hz <= 0.0 || hud_hz > GOVERNOR_HUD_HZ)) hud_hz = GOVERNOR_HUD_HZ;
+    hud_set_max_hz(hud_hz);
+    frame->shed = step;
+}
 
 void handle_keypress(SDL_Event event) {
     bool pressed = (event.type == SDL_KEYDOWN) ? true : false;
@@ -309,41 +377,65 @@ void handle_keypress(SDL_Event event) {
             }
             break;
 
+        case SDLK_b:
+            app->backend = (app->backend + 1) % BACKEND_COUNT;
+            print("Using the %s backend.\n", backend_name(app->backend));
+            break;
+
+        case SDLK_p:
+            set_pace_mode((pacer.mode + 1) % PACE_COUNT);
+            break;
+
+        case SDLK_r:
+            app->dynamic_res = !app->dynamic_res;
+            print("Dynamic resolution %s.\n", app->dynamic_res ? "on" : "off");
+            break;
+
+        case SDLK_g:
+            app->governor = !app->governor;
+            if (app->governor) {
+                governor_init(&governor, app->frame_budget_ms);
+            } else {
+                set_shed_step(&frame, GOV_NONE);
+            }
+            print("Frame budget governor %s.\n", app->governor ? "on" : "off");
+            break;
+
+        case SDLK_d:
+            app->diagnostics = !app->diagnostics;
+            break;
+
+        case SDLK_o:
+            app->on_demand = !app->on_demand;
+            print("Rendering %s.\n", app->on_demand ? "on demand" : "continuously");
+            break;
+
         case SDLK_PLUS:
         case SDLK_MINUS:
         case SDLK_KP_PLUS:
         case SDLK_KP_MINUS:
             bool adding = (event.key.keysym.sym == SDLK_PLUS) || (event.key.keysym.sym == SDLK_KP_PLUS);
 
+            double step = adding ? 0.01 : -0.01;
+
+            // Cubes belong to the simulation thread, edits get there as commands.
             switch (app->em) {
                 case EM_FOV:
                     app->fov += (adding ? 0.5 : -0.5);
                     break;
                 case EM_ROTX:
-                    (&cubes[app->current_cube])->x_rot += (adding ? 0.01 : -0.01);
+                    sim_send((sim_command){.type = CMD_ROTATE, .value = {.x = step}});
                     break;
                 case EM_ROTY:
-                    (&cubes[app->current_cube])->y_rot += (adding ? 0.01 : -0.01);
+                    sim_send((sim_command){.type = CMD_ROTATE, .value = {.y = step}});
                     break;
                 case EM_ROTZ:
-                    (&cubes[app->current_cube])->z_rot += (adding ? 0.01 : -0.01);
+                    sim_send((sim_command){.type = CMD_ROTATE, .value = {.z = step}});
                     break;
                 case EM_CUBE:
-                    app->current_cube += (adding ? 1 : -1);
-                    if (app->current_cube < 0) {
-                        app->current_cube = app->cube_count - 1;
-                    }
-                    if (app->current_cube >= app->cube_count) {
-                        app->current_cube = 0;
-                    }
+                    sim_send((sim_command){.type = CMD_SELECT, .step = adding ? 1 : -1});
                 case EM_AUTOROT:
-                    cube* cub = &cubes[app->current_cube];
-                    cub->auto_rot = !cub->auto_rot;
-                    if (cub->auto_rot) {
-                        cub->auto_x_rot = cub->x_rot;
-                        cub->auto_y_rot = cub->y_rot;
-                        cub->auto_z_rot = cub->z_rot;
-                    }
+                    sim_send((sim_command){.type = CMD_TOGGLE_AUTOROT});
                 default:
                     break;
             }
@@ -355,37 +447,355 @@ void handle_keypress(SDL_Event event) {
     }
 }
 
+void handle_window_event(SDL_Event event) {
+    switch (event.window.event) {
+        case SDL_WINDOWEVENT_HIDDEN:
+        case SDL_WINDOWEVENT_MINIMIZED:
+            window_hidden = true;
+            break;
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_EXPOSED:
+            window_hidden = false;
+            break;
+        case SDL_WINDOWEVENT_FOCUS_GAINED:
+            window_focused = true;
+            break;
+        case SDL_WINDOWEVENT_FOCUS_LOST:
+            window_focused = false;
+            break;
+        default:
+            break;
+    }
+    // Uncovered, resized or restored, the window needs its pixels back.
+    redraw_pending = true;
+}
+
+void game_handle_event(SDL_Event event) {
+    switch (event.type) {
+        case SDL_QUIT: 
+            print("Received SDL_QUIT signal.\n");
+            app->running = false;
+            break;
+
+        case SDL_RENDER_TARGETS_RESET:
+            hud_invalidate();
+            redraw_pending = true;
+            break;
+
+        case SDL_WINDOWEVENT:
+            handle_window_event(event);
+            break;
+        
+        case SDL_KEYDOWN:
+            redraw_pending = true;
+            handle_keypress(event);
+            break;
+        case SDL_KEYUP:
+            handle_keypress(event);
+            break;
+
+        default:
+            // snapshot_event only has to wake a waiting main loop, sim_fresh() tells the rest.
+            break;
+    }
+}
+
 void game_handle_events() {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-            case SDL_QUIT: 
-                print("Received SDL_QUIT signal.\n");
-                app->running = false;
-                break;
-            
-            case SDL_KEYDOWN:
-            case SDL_KEYUP:
-                handle_keypress(event);
-                break;
-
-            default:
-                break;
+        game_handle_event(event);
+    }
+}
+
+// Simulation thread, once per tick of `dt` seconds.
+void game_update(cube_pool* pool, double dt) {
+    autorot_tick(pool, dt);
+}
+
+// Simulation thread, for every command sent since the last tick.
+void game_command(cube_pool* pool, cube_handle* selected, const sim_command* cmd) {
+    int current = pool_index(pool, *selected);
+
+    switch (cmd->type) {
+        case CMD_ROTATE:
+            if (current < 0) break;
+            pool_set_rot(pool, current, (v3){
+                .x = pool->rot[current].x + cmd->value.x,
+                .y = pool->rot[current].y + cmd->value.y,
+                .z = pool->rot[current].z + cmd->value.z
+            });
+            break;
+        case CMD_SELECT:
+            if (pool->count == 0) break;
+            int index = current + cmd->step;
+            if (index < 0) {
+                index = pool->count - 1;
+            }
+            if (index >= pool->count) {
+                index = 0;
+            }
+            *selected = pool_handle_at(pool, index);
+            break;
+        case CMD_TOGGLE_AUTOROT:
+            if (current < 0) break;
+            if (pool->auto_rot[current]) {
+                autorot_stop(pool, current);
+            } else {
+                autorot_start(pool, current, (v3){
+                    .x = pool->rot[current].x * SIM_HZ,
+                    .y = pool->rot[current].y * SIM_HZ,
+                    .z = pool->rot[current].z * SIM_HZ
+                });
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Frame tasks, in dependency order.
+
+void task_events(void* ctx) {
+    game_handle_events();
+}
+
+// Picks up the newest simulation snapshot and mirrors it into the scene the renderer works on,
+// blended with the one before so motion stays smooth when ticks and frames do not line up.
+void task_sync(void* ctx) {
+    frame_ctx* frame = ctx;
+    frame->snap = sim_latest();
+    sim_mirror(frame->snap, &scene);
+    frame->alpha = app->interpolate ? sim_alpha() : 1.0;
+    if (frame->shed >= GOV_AMORTIZE) {
+        int owed;
+        frame->blended = sim_blend_part(&scene, frame->alpha, GOVERNOR_STRIDE, frames_drawn % GOVERNOR_STRIDE, &owed);
+        app->stats.blends_owed = owed;
+        // Cubes waiting for their turn still move, frames have to keep coming for them.
+        frame->blended += owed;
+    } else {
+        frame->blended = sim_blend(&scene, frame->alpha);
+    }
+}
+
+// Everything that may move cubes around in storage, the HUD waits for it.
+void task_models(void* ctx) {
+    pool_update_models(&scene);
+    if (app->morton) morton_update(&scene_order, &scene);
+}
+
+void task_transform(void* ctx) {
+    frame_ctx* frame = ctx;
+
+    // Every vertex goes through the kernels once, edges just index into the cache.
+    frame->view = frustum_make(app->fov, app->screen_width, app->screen_height);
+    bvh_update(&scene_bvh, &scene);
+    vcache_build(&vcache, &scene, app->fov, &frame->view, &scene_bvh);
+    app->stats.cubes_culled = vcache.culled;
+}
+
+void task_lines(void* ctx) {
+    frame_ctx* frame = ctx;
+    lines_begin();
+    for (int i = 0; i < scene.count; i++) {
+        render_cube(i, &frame->view, frame->shed >= GOV_LOD);
+    }
+    app->stats.lines = lines_count();
+}
+
+// CPU side rasterization of the software backends, nothing to do for the SDL one.
+void task_raster(void* ctx) {
+    frame_ctx* frame = ctx;
+    raster_resize(&soft_fb, frame->target_w, frame->target_h);
+    if (app->backend == BACKEND_SOFT) {
+        raster_clear(&soft_fb, 0xFFFFC8C8);
+        lines_flush_soft(&soft_fb);
+    } else if (app->backend == BACKEND_TILED) {
+        // Every tile clears its own pixels.
+        tiler_flush(&soft_fb, 0xFFFFC8C8);
+    }
+}
+
+void task_hud(void* ctx) {
+    render_infos();
+    // Throttled, so the HUD still owes a refresh for whatever changed this frame.
+    hud_stale = !hud_pending;
+}
+
+void task_hud_draw(void* ctx) {
+    if (hud_pending) hud_end();
+}
+
+// Below full scale the SDL backend draws into scene_target and stretches the used part over the window.
+bool begin_scene_target(const frame_ctx* frame) {
+    if (frame->scale >= 1.0) return false;
+
+    if (scene_target == NULL) {
+        scene_target = SDL_CreateTexture(
+            app->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, app->screen_width, app->screen_height
+        );
+        if (scene_target == NULL) {
+            print("Could not create the scene target, drawing at full scale: %s\n", SDL_GetError());
+            app->dynamic_res = false;
+            app->render_scale = 1.0;
+            return false;
+        }
+        SDL_SetTextureBlendMode(scene_target, SDL_BLENDMODE_NONE);
+        SDL_SetTextureScaleMode(scene_target, SDL_ScaleModeLinear);
+    }
+    SDL_SetRenderTarget(app->renderer, scene_target);
+    return true;
+}
+
+void task_draw(void* ctx) {
+    frame_ctx* frame = ctx;
+    if (app->backend == BACKEND_SOFT || app->backend == BACKEND_TILED) {
+        app->stats.draw_calls += raster_present(&soft_fb, app->renderer);
+    } else {
+        bool offscreen = begin_scene_target(frame);
+        SDL_SetRenderDrawColor(app->renderer, 255, 200, 200, 255);
+        SDL_RenderClear(app->renderer);
+        app->stats.draw_calls += lines_flush(app->renderer);
+        if (offscreen) {
+            SDL_SetRenderTarget(app->renderer, NULL);
+            SDL_Rect used = {.x = 0, .y = 0, .w = frame->target_w, .h = frame->target_h};
+            SDL_RenderCopy(app->renderer, scene_target, &used, NULL);
+            app->stats.draw_calls++;
         }
     }
 }
 
-void game_update(double dt) {
-    for (int i = 0; i < app->cube_count; i++) {
-        cube* cub = &cubes[i];
-        if (cub->auto_rot) {
-            cub->x_rot += cub->auto_x_rot;
-            cub->y_rot += cub->auto_y_rot;
-            cub->z_rot += cub->auto_z_rot;
+void task_present(void* ctx) {
+    hud_composite();
+    SDL_RenderPresent(app->renderer);
+}
+
+static const task_fn frame_tasks[FRAME_TASK_COUNT] = {
+    [FRAME_EVENTS] = task_events,
+    [FRAME_SYNC] = task_sync,
+    [FRAME_MODELS] = task_models,
+    [FRAME_TRANSFORM] = task_transform,
+    [FRAME_LINES] = task_lines,
+    [FRAME_RASTER] = task_raster,
+    [FRAME_HUD] = task_hud,
+    [FRAME_HUD_DRAW] = task_hud_draw,
+    [FRAME_DRAW] = task_draw,
+    [FRAME_PRESENT] = task_present
+};
+
+void game_frame(frame_ctx* frame) {
+    app->stats = (frame_stats){0};
+
+    // The scale is settled before any lines are made and holds for the whole frame.
+    frame->scale = app->dynamic_res ? dynres_update(&dynres, app->last_stats.work_ms) : app->render_scale;
+    dynres_size(frame->scale, app->screen_width, app->screen_height, &frame->target_w, &frame->target_h);
+    app->stats.render_scale = frame->scale;
+    app->stats.shed = frame->shed;
+
+    task_graph* g = &frame->graph;
+    tgraph_frame(g, frame_tasks, frame);
+    tgraph_run(g);
+
+    int path[TGRAPH_MAX_TASKS];
+    app->stats.graph_ms = tgraph_ms(g);
+    tgraph_critical_path(g, path, &app->stats.critical_ms);
+    // Presenting may wait for the display, which no render scale makes any shorter.
+    app->stats.work_ms = app->stats.graph_ms - task_ms(g, FRAME_PRESENT);
+    app->last_stats = app->stats;
+
+    if (app->governor) {
+        double stage_ms[GOV_STAGE_COUNT] = {
+            [GOV_STAGE_HUD] = task_ms(g, FRAME_HUD) + task_ms(g, FRAME_HUD_DRAW),
+            [GOV_STAGE_LINES] = task_ms(g, FRAME_LINES) + task_ms(g, FRAME_RASTER) + task_ms(g, FRAME_DRAW),
+            [GOV_STAGE_UPDATE] = task_ms(g, FRAME_SYNC) + task_ms(g, FRAME_MODELS)
+        };
+        // Lowering the resolution costs the least, nothing is shed while dynamic resolution can still do that.
+        bool may_shed = !app->dynamic_res || dynres.scale <= dynres.min_scale;
+        set_shed_step(frame, governor_update(&governor, app->stats.work_ms, stage_ms, may_shed));
+    }
+}
+
+void print_critical_path(const task_graph* g) {
+    int path[TGRAPH_MAX_TASKS];
+    double ms;
+    int length = tgraph_critical_path(g, path, &ms);
+
+    char line[TGRAPH_MAX_TASKS * 16] = "";
+    for (int k = 0; k < length; k++) {
+        if (k > 0) SDL_strlcat(line, " > ", sizeof(line));
+        SDL_strlcat(line, g->tasks[path[k]].name, sizeof(line));
+    }
+    print("Critical path of the last traced frame, %.3f ms of %.3f: %s\n", ms, tgraph_ms(g), line);
+}
+
+// Whether the next frame would look any different from the last one: an event changed something,
+// the simulation published, cubes are still being blended towards a snapshot, or the HUD is behind.
+bool frame_wanted() {
+    return redraw_pending || hud_stale || frame.blended > 0 || sim_fresh();
+}
+
+// Blocks until an event arrives or `timeout_ms` passes, handling the event if one did.
+void wait_for_event(int timeout_ms) {
+    SDL_Event event;
+    if (SDL_WaitEventTimeout(&event, timeout_ms)) game_handle_event(event);
+    idle_wakeups++;
+    pacer_restart(&pacer);
+}
 
-            while (cub->x_rot > 6.28) cub->x_rot -= 6.28;
-            while (cub->y_rot > 6.28) cub->y_rot -= 6.28;
-            while (cub->z_rot > 6.28) cub->z_rot -= 6.28;
+void parse_args(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+
+        if (SDL_strcmp(argv[i], "--bench") == 0 && has_value) {
+            app->bench = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--hud-hz") == 0 && has_value) {
+            app->hud_max_hz = SDL_atof(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--cubes") == 0 && has_value) {
+            app->cube_count = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--isa") == 0 && has_value) {
+            app->isa = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--threads") == 0 && has_value) {
+            app->threads = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--pin") == 0) {
+            app->pin_threads = true;
+        } else if (SDL_strcmp(argv[i], "--trace") == 0 && has_value) {
+            app->trace = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--sim-hz") == 0 && has_value) {
+            app->sim_hz = SDL_atof(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--sim-max-steps") == 0 && has_value) {
+            app->sim_max_steps = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--no-interp") == 0) {
+            app->interpolate = false;
+        } else if (SDL_strcmp(argv[i], "--fps") == 0 && has_value) {
+            app->target_fps = SDL_atof(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--pace") == 0 && has_value) {
+            int mode = pace_mode_from_name(argv[++i]);
+            if (mode < 0) {
+                print("Unknown pacing \"%s\", using %s.\n", argv[i], pace_mode_name(app->pace));
+            } else {
+                app->pace = mode;
+            }
+        } else if (SDL_strcmp(argv[i], "--render-scale") == 0 && has_value) {
+            app->render_scale = SDL_atof(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--dynamic-res") == 0) {
+            app->dynamic_res = true;
+        } else if (SDL_strcmp(argv[i], "--frame-budget") == 0 && has_value) {
+            app->frame_budget_ms = SDL_atof(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--governor") == 0) {
+            app->governor = true;
+        } else if (SDL_strcmp(argv[i], "--on-demand") == 0) {
+            app->on_demand = true;
+        } else if (SDL_strcmp(argv[i], "--morton") == 0) {
+            app->morton = true;
+        } else if (SDL_strcmp(argv[i], "--backend") == 0 && has_value) {
+            int backend = backend_from_name(argv[++i]);
+            if (backend < 0) {
+                print("Unknown backend \"%s\", using %s.\n", argv[i], backend_name(app->backend));
+            } else {
+                app->backend = backend;
+            }
+        } else {
+            print("Ignoring unknown argument \"%s\".\n", argv[i]);
         }
     }
 }
@@ -400,23 +810,61 @@ int main(int argc, char** argv) {
     app->screen_height = 600;
 
     app->fov = 120.0;
-    app->cube_count = sizeof(cubes) / sizeof(cube);
-    app->current_cube = 0;
     app->em = EM_FOV;
-
-    create_cube(
-        0,
-        150.0, 200.0, 0.0,
-        100.0, 100.0, 50.0
-    );
-
-    create_cube(
-        1,
-        350.0, 200.0, 0.0,
-        100.0, 100.0, 50.0
-    );
+    app->bench = NULL;
+    app->hud_max_hz = 0.0;
+    app->cube_count = 0;
+    app->isa = NULL;
+    app->threads = 0;
+    app->pin_threads = false;
+    app->morton = false;
+    app->backend = BACKEND_SDL;
+    app->trace = NULL;
+    app->sim_hz = SIM_HZ;
+    app->sim_max_steps = SIM_MAX_STEPS;
+    app->interpolate = true;
+    app->pace = PACE_TIMER;
+    app->target_fps = 60.0;
+    app->on_demand = false;
+    app->render_scale = 1.0;
+    app->dynamic_res = false;
+    app->frame_budget_ms = 0.0;
+    app->governor = false;
+    app->diagnostics = false;
+    app->stats = app->last_stats = (frame_stats){0};
+
+    parse_args(argc, argv);
+    if (app->sim_hz <= 0.0) app->sim_hz = SIM_HZ;
+    if (app->render_scale <= 0.0 || app->render_scale > 1.0) app->render_scale = 1.0;
+    if (app->frame_budget_ms <= 0.0) app->frame_budget_ms = 1000.0 / app->target_fps;
+    // A fixed --render-scale below the default floor lowers it, the controller never goes smaller.
+    dynres_init(&dynres, app->frame_budget_ms, fmin(app->render_scale, DYNRES_MIN_SCALE));
+    governor_init(&governor, app->frame_budget_ms);
+
+    sim_init(1.0 / app->sim_hz, game_update, game_command);
+    sim_set_max_steps(app->sim_max_steps);
+    pool_init(&scene, (app->cube_count > 0) ? app->cube_count : 2);
+    vcache_init(&vcache);
+    bvh_init(&scene_bvh);
+    morton_init(&scene_order);
+    if (app->cube_count > 0) {
+        create_cube_grid(app->cube_count);
+    } else {
+        create_cube(
+            150.0, 200.0, 0.0,
+            100.0, 100.0, 50.0
+        );
+
+        create_cube(
+            350.0, 200.0, 0.0,
+            100.0, 100.0, 50.0
+        );
+    }
+    *sim_selected() = pool_handle_at(sim_pool(), 0);
 
     print("Initialized cubes.\n");
+    dispatch_init(app->isa);
+    jobs_init(app->threads, app->pin_threads);
 
     assert(SDL_Init(SDL_INIT_EVERYTHING) == 0);
     app->window = SDL_CreateWindow(
@@ -426,33 +874,74 @@ int main(int argc, char** argv) {
         0
     );
     assert(app->window != NULL);
-    app->renderer = SDL_CreateRenderer(app->window, -1, 0);
+    app->renderer = SDL_CreateRenderer(app->window, -1, (app->pace == PACE_VSYNC) ? SDL_RENDERER_PRESENTVSYNC : 0);
     assert(app->renderer != NULL);
     assert(SDL_SetRenderDrawBlendMode(app->renderer, SDL_BLENDMODE_BLEND) == 0);
     print("Initialized application window and renderer.\n");
     assert(TTF_Init() == 0);
     app->font = TTF_OpenFont("./OpenSans-Regular.ttf", 24);
     assert(app->font != NULL);
+    assert(text_init(app->renderer, app->font));
+    assert(hud_init(app->renderer, app->screen_width, app->screen_height));
+    assert(raster_init(&soft_fb, app->renderer, app->screen_width, app->screen_height));
+    trig_select(app->screen_width, app->screen_height, 0.5);
+    hud_set_max_hz(app->hud_max_hz);
+
+    if (app->bench != NULL) {
+        return bench_run(app->bench);
+    }
 
+    assert(tgraph_init(&frame.graph));
+    snapshot_event = SDL_RegisterEvents(1);
+    if (snapshot_event == (Uint32)-1) snapshot_event = 0;
+    sim_set_notify(snapshot_event);
+    sim_start();
 
-    double last_tick = (double)SDL_GetTicks();
-    double current_tick = (double)SDL_GetTicks();
-    double delta_accum = 0.0;
-    double frametime = 1.0 / 50.0;
+    bool tracing = (app->trace != NULL) && tgraph_trace_open(app->trace);
+    int frame_index = 0;
+
+    pacer_init(&pacer, app->pace, app->target_fps);
 
     print("Entering the mainloop.\n");
+    double last_frame = 0.0;
     while (app->running) {
-        current_tick = (double)SDL_GetTicks();
-        delta_accum += (current_tick - last_tick) / 1000.0;
-        last_tick = current_tick;
-        
-        game_handle_events();
-        while (delta_accum >= frametime) {
-            game_update(frametime);
-            delta_accum -= frametime;
+        // Nothing to show while hidden, and an unfocused window gets a few frames a second at most.
+        if (window_hidden) {
+            wait_for_event(IDLE_TIMEOUT_MS);
+            continue;
+        }
+        double background_wait = last_frame + 1.0 / BACKGROUND_FPS - pacer_now();
+        if (!window_focused && background_wait > 0.0) {
+            wait_for_event((int)(background_wait * 1000.0) + 1);
+            continue;
         }
-        game_render();
+        if (app->on_demand && !frame_wanted()) {
+            wait_for_event(IDLE_TIMEOUT_MS);
+            continue;
+        }
+
+        game_frame(&frame);
+        // Events handled during the frame are already in it.
+        redraw_pending = false;
+        last_frame = pacer_now();
+        frames_drawn++;
+
+        if (tracing) {
+            tgraph_trace_frame(&frame.graph, frame_index);
+            if (frame_index + 1 == TRACE_FRAMES) {
+                tgraph_trace_close();
+                tracing = false;
+                print_critical_path(&frame.graph);
+            }
+        }
+        frame_index++;
+        pacer_wait(&pacer);
+    }
+    if (tracing) {
+        tgraph_trace_close();
+        print_critical_path(&frame.graph);
     }
+    sim_stop();
 
     return 0;
 }
\ No newline at end of file
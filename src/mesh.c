@@ -0,0 +1,181 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<assert.h>
+#include<malloc.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<pool.h>
+#include<mesh.h>
+#include<xform.h>
+#include<dispatch.h>
+#include<jobs.h>
+
+// Cubes, or vertex groups, per chunk below which a loop is not worth handing to another thread.
+#define VCACHE_GRAIN 1024
+// Projection works on whole groups of this many vertices, a multiple of every SIMD width.
+#define VCACHE_GROUP 8
+
+static const float cube_x[CUBE_CORNERS] = {-1, 1, -1, 1, -1, 1, -1, 1};
+static const float cube_y[CUBE_CORNERS] = {-1, -1, 1, 1, -1, -1, 1, 1};
+static const float cube_z[CUBE_CORNERS] = {-1, -1, -1, -1, 1, 1, 1, 1};
+
+static const mesh_edge cube_edges[] = {
+    // "Front" cube
+    {CORNER_FTL, CORNER_FTR, LINE_FRONT}, // Top horizontal
+    {CORNER_FTR, CORNER_FBR, LINE_FRONT}, // Right vertical
+    {CORNER_FBR, CORNER_FBL, LINE_FRONT}, // Bottom horizontal
+    {CORNER_FBL, CORNER_FTL, LINE_FRONT}, // Left vertical
+
+    // "Back" cube
+    {CORNER_BTL, CORNER_BTR, LINE_BACK}, // Top horizontal
+    {CORNER_BTR, CORNER_BBR, LINE_BACK}, // Right vertical
+    {CORNER_BBR, CORNER_BBL, LINE_BACK}, // Bottom horizontal
+    {CORNER_BBL, CORNER_BTL, LINE_BACK}, // Left vertical
+
+    // Connections between both cubes
+    {CORNER_FTL, CORNER_BTL, LINE_CONNECT}, // Top left
+    {CORNER_FTR, CORNER_BTR, LINE_CONNECT}, // Top right
+    {CORNER_FBL, CORNER_BBL, LINE_CONNECT}, // Bottom left
+    {CORNER_FBR, CORNER_BBR, LINE_CONNECT}, // Bottom right
+};
+
+const wire_mesh mesh_cube = {
+    .name = "cube",
+    .vertex_count = CUBE_CORNERS,
+    .x = cube_x,
+    .y = cube_y,
+    .z = cube_z,
+    .radius = 1.7320508f,   // sqrt(3)
+    .box = 1.0f,
+    .edge_count = (int)(sizeof(cube_edges) / sizeof(cube_edges[0])),
+    .edges = cube_edges
+};
+
+void vcache_init(vertex_cache* cache) {
+    memset(cache, 0, sizeof(vertex_cache));
+}
+
+void vcache_destroy(vertex_cache* cache) {
+    SDL_SIMDFree(cache->world_x);
+    SDL_SIMDFree(cache->world_y);
+    SDL_SIMDFree(cache->world_z);
+    SDL_SIMDFree(cache->proj_x);
+    SDL_SIMDFree(cache->proj_y);
+    free(cache->base);
+    free(cache->visible);
+    memset(cache, 0, sizeof(vertex_cache));
+}
+
+static void reserve_vertices(vertex_cache* cache, int count) {
+    if (count <= cache->capacity) return;
+
+    int grown = (cache->capacity > 0) ? cache->capacity : 128;
+    while (grown < count) grown *= 2;
+
+    size_t size = sizeof(float) * grown;
+    cache->world_x = SDL_SIMDRealloc(cache->world_x, size);
+    cache->world_y = SDL_SIMDRealloc(cache->world_y, size);
+    cache->world_z = SDL_SIMDRealloc(cache->world_z, size);
+    cache->proj_x = SDL_SIMDRealloc(cache->proj_x, size);
+    cache->proj_y = SDL_SIMDRealloc(cache->proj_y, size);
+    assert(cache->world_x != NULL && cache->world_y != NULL && cache->world_z != NULL);
+    assert(cache->proj_x != NULL && cache->proj_y != NULL);
+    cache->capacity = grown;
+}
+
+typedef struct xform_job {
+    vertex_cache* cache;
+    const cube_pool* pool;
+    double fov;
+    int total;
+} xform_job;
+
+// Transforms cubes [begin, end). Their vertices have fixed places given by base,
+// so chunks never overlap and the result is the same however the cubes are split.
+static void xform_range(void* ctx, int begin, int end, int worker) {
+    xform_job* job = ctx;
+    vertex_cache* cache = job->cache;
+    const cube_pool* pool = job->pool;
+
+    int i = begin;
+    while (i < end) {
+        const wire_mesh* mesh = pool->mesh[i];
+        int at = cache->base[i];
+
+        if (cache->visible[i] == CULL_OUTSIDE) {
+            i++;
+        } else if (mesh == &mesh_cube) {
+            // Runs of cubes take the batch kernel, their corners are constants it never loads.
+            int run = i + 1;
+            while (run < end && pool->mesh[run] == &mesh_cube && cache->visible[run] != CULL_OUTSIDE) run++;
+            kern.xform_cubes(pool->model, i, run - i, &cache->world_x[at], &cache->world_y[at], &cache->world_z[at]);
+            i = run;
+        } else {
+            kern.xform_points(
+                &pool->model[i], mesh->x, mesh->y, mesh->z, mesh->vertex_count,
+                &cache->world_x[at], &cache->world_y[at], &cache->world_z[at]
+            );
+            i++;
+        }
+    }
+
+}
+
+// Projects vertex groups [begin, end), VCACHE_GROUP vertices each.
+// Group edges do not depend on how the loop is split, so the SIMD kernels always leave the same
+// vertices to their scalar tail and the output is the same on any thread count.
+static void project_range(void* ctx, int begin, int end, int worker) {
+    xform_job* job = ctx;
+    vertex_cache* cache = job->cache;
+
+    // Vertices behind the near plane project to garbage here, clip_edge() never reads those.
+    int first = begin * VCACHE_GROUP;
+    int last = (end * VCACHE_GROUP < job->total) ? end * VCACHE_GROUP : job->total;
+    kern.project(
+        &cache->world_x[first], &cache->world_y[first], &cache->world_z[first], last - first, job->fov,
+        &cache->proj_x[first], &cache->proj_y[first]
+    );
+}
+
+int vcache_build(vertex_cache* cache, const cube_pool* pool, double fov, const frustum* view, const bvh* tree) {
+    if (pool->count > cache->base_capacity) {
+        cache->base_capacity = pool->count * 2;
+        cache->base = realloc(cache->base, sizeof(int) * cache->base_capacity);
+        cache->visible = realloc(cache->visible, sizeof(Uint8) * cache->base_capacity);
+        assert(cache->base != NULL && cache->visible != NULL);
+    }
+
+    cache->culled = 0;
+    if (view != NULL && tree != NULL) {
+        assert(tree->cube_count == pool->count);
+        cache->culled = bvh_cull(tree, view, cache->visible);
+    } else {
+        for (int i = 0; i < pool->count; i++) {
+            enum CullResult cull = CULL_INTERSECT;
+            if (view != NULL) {
+                v3 e = pool->extent[i];
+                double radius = pool->mesh[i]->radius * fmax(fabs(e.x), fmax(fabs(e.y), fabs(e.z)));
+                cull = frustum_test_sphere(view, pool->center[i], radius);
+            }
+            cache->visible[i] = (Uint8)cull;
+            if (cull == CULL_OUTSIDE) cache->culled++;
+        }
+    }
+
+    int total = 0;
+    for (int i = 0; i < pool->count; i++) {
+        cache->base[i] = total;
+        if (cache->visible[i] != CULL_OUTSIDE) total += pool->mesh[i]->vertex_count;
+    }
+    reserve_vertices(cache, total);
+    cache->count = total;
+
+    xform_job job = {.cache = cache, .pool = pool, .fov = fov, .total = total};
+    jobs_parallel_for(pool->count, jobs_chunks_for(pool->count, VCACHE_GRAIN), xform_range, &job);
+    int groups = (total + VCACHE_GROUP - 1) / VCACHE_GROUP;
+    jobs_parallel_for(groups, jobs_chunks_for(groups, VCACHE_GRAIN), project_range, &job);
+    return total;
+}
@@ -0,0 +1,248 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<assert.h>
+#include<malloc.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<pool.h>
+#include<jobs.h>
+#include<morton.h>
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+// Below this many items one thread sorts faster than waking the others.
+#define RADIX_PARALLEL_MIN 16384
+
+// Spreads the low 10 bits of v two zero bits apart.
+static Uint32 spread_bits(Uint32 v) {
+    v &= 0x3FF;
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+Uint32 morton_encode(Uint32 x, Uint32 y, Uint32 z) {
+    return spread_bits(x) | (spread_bits(y) << 1) | (spread_bits(z) << 2);
+}
+
+static Uint32 quantize(double v, double origin, double cells_per_unit) {
+    double cell = (v - origin) * cells_per_unit;
+    if (cell < 0) cell = 0;
+    if (cell > (1 << MORTON_AXIS_BITS) - 1) cell = (1 << MORTON_AXIS_BITS) - 1;
+    return (Uint32)cell;
+}
+
+static Uint32 center_code(const morton_order* mo, v3 c) {
+    return morton_encode(
+        quantize(c.x, mo->origin.x, mo->cells_per_unit),
+        quantize(c.y, mo->origin.y, mo->cells_per_unit),
+        quantize(c.z, mo->origin.z, mo->cells_per_unit)
+    );
+}
+
+void morton_init(morton_order* mo) {
+    memset(mo, 0, sizeof(morton_order));
+    mo->resort_fraction = 1.0 / 16.0;
+}
+
+void morton_destroy(morton_order* mo) {
+    free(mo->keys);
+    free(mo->keys_swap);
+    free(mo->order);
+    free(mo->order_swap);
+    memset(mo, 0, sizeof(morton_order));
+}
+
+// One counting pass of the radix sort.
+// Items are split into the same fixed chunks for the histogram and the scatter, each chunk writes
+// after every chunk before it within a bucket, which keeps the sort stable on any thread count.
+typedef struct radix_pass {
+    const Uint32* keys_in;
+    const int* values_in;
+    Uint32* keys_out;
+    int* values_out;
+    int count;
+    int chunks;
+    int shift;
+    int* offsets;   // chunks * RADIX_BUCKETS, counts first, then write positions
+} radix_pass;
+
+static void radix_count(void* ctx, int begin, int end, int worker) {
+    radix_pass* pass = ctx;
+    for (int chunk = begin; chunk < end; chunk++) {
+        int* counts = &pass->offsets[chunk * RADIX_BUCKETS];
+        memset(counts, 0, sizeof(int) * RADIX_BUCKETS);
+
+        int first, last;
+        jobs_chunk_range(pass->count, pass->chunks, chunk, &first, &last);
+        for (int i = first; i < last; i++) {
+            counts[(pass->keys_in[i] >> pass->shift) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+}
+
+static void radix_scatter(void* ctx, int begin, int end, int worker) {
+    radix_pass* pass = ctx;
+    for (int chunk = begin; chunk < end; chunk++) {
+        int* at = &pass->offsets[chunk * RADIX_BUCKETS];
+
+        int first, last;
+        jobs_chunk_range(pass->count, pass->chunks, chunk, &first, &last);
+        for (int i = first; i < last; i++) {
+            Uint32 key = pass->keys_in[i];
+            int to = at[(key >> pass->shift) & (RADIX_BUCKETS - 1)]++;
+            pass->keys_out[to] = key;
+            pass->values_out[to] = pass->values_in[i];
+        }
+    }
+}
+
+static int* radix_offsets = NULL;
+static int radix_offsets_capacity = 0;
+
+void radix_sort_pairs(Uint32* keys, int* values, Uint32* keys_swap, int* values_swap, int count, int key_bits) {
+    int chunks = (count >= RADIX_PARALLEL_MIN) ? jobs_thread_count() : 1;
+    if (chunks * RADIX_BUCKETS > radix_offsets_capacity) {
+        radix_offsets_capacity = chunks * RADIX_BUCKETS;
+        radix_offsets = realloc(radix_offsets, sizeof(int) * radix_offsets_capacity);
+        assert(radix_offsets != NULL);
+    }
+
+    radix_pass pass = {
+        .keys_in = keys,
+        .values_in = values,
+        .keys_out = keys_swap,
+        .values_out = values_swap,
+        .count = count,
+        .chunks = chunks,
+        .offsets = radix_offsets
+    };
+
+    int passes = (key_bits + RADIX_BITS - 1) / RADIX_BITS;
+    for (int p = 0; p < passes; p++) {
+        pass.shift = p * RADIX_BITS;
+        jobs_parallel_for(chunks, chunks, radix_count, &pass);
+
+        // Bucket by bucket, chunk by chunk: where each chunk starts writing each bucket.
+        int total = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            for (int c = 0; c < chunks; c++) {
+                int n = pass.offsets[c * RADIX_BUCKETS + b];
+                pass.offsets[c * RADIX_BUCKETS + b] = total;
+                total += n;
+            }
+        }
+        jobs_parallel_for(chunks, chunks, radix_scatter, &pass);
+
+        const Uint32* k = pass.keys_in;
+        const int* v = pass.values_in;
+        pass.keys_in = pass.keys_out;
+        pass.values_in = pass.values_out;
+        pass.keys_out = (Uint32*)k;
+        pass.values_out = (int*)v;
+    }
+
+    if (passes % 2 == 1) {
+        memcpy(keys, keys_swap, sizeof(Uint32) * count);
+        memcpy(values, values_swap, sizeof(int) * count);
+    }
+}
+
+typedef struct encode_ctx {
+    const morton_order* mo;
+    const cube_pool* pool;
+    Uint32* keys;
+    int* order;
+} encode_ctx;
+
+static void encode_range(void* ctx, int begin, int end, int worker) {
+    encode_ctx* e = ctx;
+    for (int i = begin; i < end; i++) {
+        e->keys[i] = center_code(e->mo, e->pool->center[i]);
+        e->order[i] = i;
+    }
+}
+
+void morton_sort(morton_order* mo, cube_pool* pool) {
+    int n = pool->count;
+    if (n > mo->capacity) {
+        mo->capacity = n * 2;
+        mo->keys = realloc(mo->keys, sizeof(Uint32) * mo->capacity);
+        mo->keys_swap = realloc(mo->keys_swap, sizeof(Uint32) * mo->capacity);
+        mo->order = realloc(mo->order, sizeof(int) * mo->capacity);
+        mo->order_swap = realloc(mo->order_swap, sizeof(int) * mo->capacity);
+        assert(mo->keys != NULL && mo->keys_swap != NULL && mo->order != NULL && mo->order_swap != NULL);
+    }
+
+    // Cells are cubes, the longest side of the bounds gets all 1024 of them.
+    v3 lo = {0, 0, 0};
+    v3 hi = {0, 0, 0};
+    for (int i = 0; i < n; i++) {
+        v3 c = pool->center[i];
+        if (i == 0 || c.x < lo.x) lo.x = c.x;
+        if (i == 0 || c.y < lo.y) lo.y = c.y;
+        if (i == 0 || c.z < lo.z) lo.z = c.z;
+        if (i == 0 || c.x > hi.x) hi.x = c.x;
+        if (i == 0 || c.y > hi.y) hi.y = c.y;
+        if (i == 0 || c.z > hi.z) hi.z = c.z;
+    }
+    double span = fmax(hi.x - lo.x, fmax(hi.y - lo.y, hi.z - lo.z));
+    mo->origin = lo;
+    mo->cells_per_unit = (span > 0) ? ((1 << MORTON_AXIS_BITS) - 1) / span : 1.0;
+
+    encode_ctx e = {.mo = mo, .pool = pool, .keys = mo->keys, .order = mo->order};
+    jobs_parallel_for(n, jobs_thread_count() * 4, encode_range, &e);
+    radix_sort_pairs(mo->keys, mo->order, mo->keys_swap, mo->order_swap, n, 3 * MORTON_AXIS_BITS);
+
+    pool_reorder(pool, mo->order);
+    memcpy(pool->morton, mo->keys, sizeof(Uint32) * n);
+
+    mo->displaced = 0;
+    mo->sorted = true;
+    mo->layout_version = pool->layout_version;
+    mo->sorts++;
+}
+
+bool morton_update(morton_order* mo, cube_pool* pool) {
+    if (!mo->sorted) {
+        morton_sort(mo, pool);
+        return true;
+    }
+
+    if (mo->layout_version != pool->layout_version) {
+        // Cubes came or went: the new ones sit at the end, removals moved the last cube into the hole.
+        // Count whatever breaks the order.
+        mo->displaced = 0;
+        Uint32 previous = 0;
+        for (int i = 0; i < pool->count; i++) {
+            Uint32 code = center_code(mo, pool->center[i]);
+            if (code < previous) mo->displaced++;
+            pool->morton[i] = code;
+            previous = code;
+        }
+        mo->layout_version = pool->layout_version;
+    } else {
+        // Only cubes whose model changed can have moved.
+        for (int c = 0; c < pool->changed_count; c++) {
+            int i = pool->changed[c];
+            if (pool->morton[i] & MORTON_DISPLACED) continue;
+
+            Uint32 code = center_code(mo, pool->center[i]);
+            if ((code >> MORTON_CELL_SHIFT) != (pool->morton[i] >> MORTON_CELL_SHIFT)) {
+                pool->morton[i] |= MORTON_DISPLACED;
+                mo->displaced++;
+            }
+        }
+    }
+
+    if (mo->displaced > pool->count * mo->resort_fraction) {
+        morton_sort(mo, pool);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,112 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<pacer.h>
+
+// How late SDL_Delay() is assumed to wake up until it has been seen doing it.
+#define PACER_INITIAL_OVERSLEEP 0.0015
+
+static const char* mode_names[PACE_COUNT] = {
+    [PACE_NONE] = "none",
+    [PACE_TIMER] = "timer",
+    [PACE_VSYNC] = "vsync"
+};
+
+const char* pace_mode_name(enum PaceMode mode) {
+    return (mode >= 0 && mode < PACE_COUNT) ? mode_names[mode] : "unknown";
+}
+
+int pace_mode_from_name(const char* name) {
+    for (int m = 0; m < PACE_COUNT; m++) {
+        if (SDL_strcasecmp(name, mode_names[m]) == 0) return m;
+    }
+    return -1;
+}
+
+double pacer_now() {
+    return (double)SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+}
+
+void pacer_init(frame_pacer* pacer, enum PaceMode mode, double target_hz) {
+    memset(pacer, 0, sizeof(frame_pacer));
+    pacer->frequency = SDL_GetPerformanceFrequency();
+    pacer->oversleep = PACER_INITIAL_OVERSLEEP;
+    pacer->frame_start = SDL_GetPerformanceCounter();
+    pacer_set_target(pacer, target_hz);
+    pacer_set_mode(pacer, mode);
+}
+
+void pacer_set_mode(frame_pacer* pacer, enum PaceMode mode) {
+    pacer->mode = mode;
+    pacer->deadline = SDL_GetPerformanceCounter() + pacer->period;
+}
+
+void pacer_set_target(frame_pacer* pacer, double target_hz) {
+    pacer->target_hz = (target_hz > 0.0) ? target_hz : 60.0;
+    pacer->period = (Uint64)(pacer->frequency / pacer->target_hz);
+    pacer->deadline = SDL_GetPerformanceCounter() + pacer->period;
+}
+
+void pacer_restart(frame_pacer* pacer) {
+    pacer->frame_start = SDL_GetPerformanceCounter();
+    pacer->deadline = pacer->frame_start + pacer->period;
+}
+
+static double counts_ms(const frame_pacer* pacer, Uint64 counts) {
+    return (double)counts * 1000.0 / (double)pacer->frequency;
+}
+
+// Sleeps in whole milliseconds until the learned oversleep plus a little is left, then spins.
+static void wait_until(frame_pacer* pacer, Uint64 deadline) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 margin = (Uint64)((pacer->oversleep + PACER_SPIN_SECONDS) * pacer->frequency);
+    if (deadline > now + margin) {
+        Uint32 ms = (Uint32)((deadline - now - margin) * 1000 / pacer->frequency);
+        if (ms > 0) {
+            Uint64 before = now;
+            SDL_Delay(ms);
+            now = SDL_GetPerformanceCounter();
+            pacer->sleep_ms = counts_ms(pacer, now - before);
+
+            // Follows a later wake-up at once, an earlier one only slowly, so one lucky sleep
+            // does not shrink the margin to where the next unlucky one misses the deadline.
+            double late = (pacer->sleep_ms - ms) / 1000.0;
+            if (late < 0.0) late = 0.0;
+            if (late > pacer->oversleep) {
+                pacer->oversleep = late;
+            } else {
+                pacer->oversleep += (late - pacer->oversleep) * 0.02;
+            }
+        }
+    }
+
+    Uint64 spin_start = now;
+    while (now < deadline) {
+        SDL_CPUPauseInstruction();
+        now = SDL_GetPerformanceCounter();
+    }
+    pacer->spin_ms = counts_ms(pacer, now - spin_start);
+}
+
+void pacer_wait(frame_pacer* pacer) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    pacer->work_ms = counts_ms(pacer, now - pacer->frame_start);
+    pacer->sleep_ms = pacer->spin_ms = 0.0;
+
+    if (pacer->mode == PACE_TIMER) {
+        if (now >= pacer->deadline) {
+            pacer->missed++;
+            pacer->deadline = now;
+        } else {
+            wait_until(pacer, pacer->deadline);
+        }
+        pacer->deadline += pacer->period;
+    }
+
+    Uint64 end = SDL_GetPerformanceCounter();
+    pacer->frame_ms = counts_ms(pacer, end - pacer->frame_start);
+    pacer->frame_start = end;
+}
@@ -0,0 +1,321 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<math.h>
+#include<assert.h>
+#include<malloc.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<pool.h>
+#include<trig.h>
+#include<jobs.h>
+
+#define FREE_END 0xFFFFFFFF
+// Cubes per chunk below which rebuilding models is not worth handing to another thread.
+#define POOL_GRAIN 2048
+
+// Cache line aligned allocations, the original pointer is stashed right before the aligned block.
+static void* aligned_alloc_line(size_t size) {
+    Uint8* raw = malloc(size + CACHE_LINE + sizeof(void*));
+    if (raw == NULL) return NULL;
+    uintptr_t aligned = ((uintptr_t)(raw + sizeof(void*)) + CACHE_LINE - 1) & ~(uintptr_t)(CACHE_LINE - 1);
+    ((void**)aligned)[-1] = raw;
+    return (void*)aligned;
+}
+
+static void aligned_free_line(void* mem) {
+    if (mem != NULL) free(((void**)mem)[-1]);
+}
+
+static void* aligned_grow(void* mem, size_t used, size_t size) {
+    void* grown = aligned_alloc_line(size);
+    assert(grown != NULL);
+    if (mem != NULL) {
+        memcpy(grown, mem, used);
+        aligned_free_line(mem);
+    }
+    return grown;
+}
+
+// Every per-cube array, in one place so growing and swapping cannot miss a field.
+#define POOL_FIELDS(X) \
+    X(center) \
+    X(extent) \
+    X(rot) \
+    X(rot_vel) \
+    X(auto_rot) \
+    X(mesh) \
+    X(rot_sin) \
+    X(rot_cos) \
+    X(step_sin) \
+    X(step_cos) \
+    X(orient) \
+    X(model) \
+    X(dirty) \
+    X(morton) \
+    X(dense_to_slot)
+
+static void grow_dense(cube_pool* pool, int capacity) {
+    #define GROW_FIELD(f) \
+        pool->f = aligned_grow(pool->f, sizeof(*pool->f) * pool->count, sizeof(*pool->f) * capacity);
+    POOL_FIELDS(GROW_FIELD)
+    #undef GROW_FIELD
+    pool->changed = aligned_grow(pool->changed, 0, sizeof(int) * capacity);
+    pool->changed_count = 0;
+    pool->capacity = capacity;
+}
+
+void pool_init(cube_pool* pool, int capacity) {
+    memset(pool, 0, sizeof(cube_pool));
+    pool->free_head = FREE_END;
+    if (capacity < 16) capacity = 16;
+
+    grow_dense(pool, capacity);
+
+    pool->slot_capacity = capacity;
+    pool->slot_to_dense = aligned_grow(NULL, 0, sizeof(Uint32) * capacity);
+    pool->generations = aligned_grow(NULL, 0, sizeof(Uint32) * capacity);
+}
+
+void pool_destroy(cube_pool* pool) {
+    #define FREE_FIELD(f) aligned_free_line(pool->f);
+    POOL_FIELDS(FREE_FIELD)
+    #undef FREE_FIELD
+    aligned_free_line(pool->changed);
+    aligned_free_line(pool->slot_to_dense);
+    aligned_free_line(pool->generations);
+    memset(pool, 0, sizeof(cube_pool));
+}
+
+static Uint32 take_slot(cube_pool* pool) {
+    if (pool->free_head != FREE_END) {
+        Uint32 slot = pool->free_head;
+        pool->free_head = pool->slot_to_dense[slot];
+        return slot;
+    }
+
+    if (pool->slot_count == pool->slot_capacity) {
+        int grown = pool->slot_capacity * 2;
+        pool->slot_to_dense = aligned_grow(pool->slot_to_dense, sizeof(Uint32) * pool->slot_count, sizeof(Uint32) * grown);
+        pool->generations = aligned_grow(pool->generations, sizeof(Uint32) * pool->slot_count, sizeof(Uint32) * grown);
+        pool->slot_capacity = grown;
+    }
+    Uint32 slot = (Uint32)pool->slot_count++;
+    pool->generations[slot] = 1;
+    return slot;
+}
+
+cube_handle pool_add(cube_pool* pool, int* out_index) {
+    if (pool->count == pool->capacity) {
+        grow_dense(pool, pool->capacity * 2);
+    }
+
+    Uint32 slot = take_slot(pool);
+    int index = pool->count++;
+    pool->slot_to_dense[slot] = (Uint32)index;
+    #define ZERO_FIELD(f) memset(&pool->f[index], 0, sizeof(*pool->f));
+    POOL_FIELDS(ZERO_FIELD)
+    #undef ZERO_FIELD
+    pool->dense_to_slot[index] = slot;
+    pool->mesh[index] = &mesh_cube;
+    pool->dirty[index] = DIRTY_MODEL | DIRTY_ROTATION;
+    pool->layout_version++;
+
+    if (out_index != NULL) *out_index = index;
+    return (cube_handle){.slot = slot, .generation = pool->generations[slot]};
+}
+
+bool pool_remove(cube_pool* pool, cube_handle handle) {
+    int index = pool_index(pool, handle);
+    if (index < 0) return false;
+
+    // Keep the live range packed by moving the last cube into the hole.
+    int last = pool->count - 1;
+    if (index != last) {
+        #define MOVE_FIELD(f) pool->f[index] = pool->f[last];
+        POOL_FIELDS(MOVE_FIELD)
+        #undef MOVE_FIELD
+        pool->slot_to_dense[pool->dense_to_slot[index]] = (Uint32)index;
+    }
+    pool->count--;
+    pool->layout_version++;
+
+    pool->generations[handle.slot]++;
+    pool->slot_to_dense[handle.slot] = pool->free_head;
+    pool->free_head = handle.slot;
+    return true;
+}
+
+void pool_clear(cube_pool* pool) {
+    while (pool->count > 0) {
+        pool_remove(pool, pool_handle_at(pool, pool->count - 1));
+    }
+}
+
+// Field-sized scratch for pool_reorder(), only ever grows.
+static void* reorder_scratch = NULL;
+static size_t reorder_scratch_size = 0;
+
+void pool_reorder(cube_pool* pool, const int* order) {
+    size_t largest = 0;
+    #define FIELD_SIZE(f) if (sizeof(*pool->f) > largest) largest = sizeof(*pool->f);
+    POOL_FIELDS(FIELD_SIZE)
+    #undef FIELD_SIZE
+    size_t size = largest * pool->count;
+    if (size > reorder_scratch_size) {
+        reorder_scratch = realloc(reorder_scratch, size);
+        assert(reorder_scratch != NULL);
+        reorder_scratch_size = size;
+    }
+
+    // Gather every field into the scratch in the new order, then copy it back.
+    #define REORDER_FIELD(f) { \
+            __typeof__(pool->f) gathered = reorder_scratch; \
+            for (int k = 0; k < pool->count; k++) gathered[k] = pool->f[order[k]]; \
+            memcpy(pool->f, gathered, sizeof(*pool->f) * pool->count); \
+        }
+    POOL_FIELDS(REORDER_FIELD)
+    #undef REORDER_FIELD
+
+    for (int k = 0; k < pool->count; k++) {
+        pool->slot_to_dense[pool->dense_to_slot[k]] = (Uint32)k;
+    }
+    // Indices from before the move mean nothing anymore.
+    pool->changed_count = 0;
+    pool->layout_version++;
+}
+
+// Exact, for the one-off syncs that later incremental rotation builds on.
+void pool_sync_rotation(cube_pool* pool, int index) {
+    v3 rot = pool->rot[index];
+    pool->rot_sin[index] = (v3){.x = sin(rot.x), .y = sin(rot.y), .z = sin(rot.z)};
+    pool->rot_cos[index] = (v3){.x = cos(rot.x), .y = cos(rot.y), .z = cos(rot.z)};
+    pool->dirty[index] &= ~DIRTY_ROTATION;
+}
+
+// Scratch for batching the trig of directly set angles, three angles per cube.
+// Per thread, the simulation's pool is synced on its own thread while the renderer runs.
+static __thread double* batch_angles = NULL;
+static __thread double* batch_sin = NULL;
+static __thread double* batch_cos = NULL;
+static __thread int* batch_cubes = NULL;
+static __thread int batch_capacity = 0;
+
+int pool_sync_rotations(cube_pool* pool) {
+    int count = 0;
+    for (int i = 0; i < pool->count; i++) {
+        if (!(pool->dirty[i] & DIRTY_ROTATION)) continue;
+
+        if (count == batch_capacity) {
+            batch_capacity = (batch_capacity > 0) ? batch_capacity * 2 : 64;
+            batch_angles = realloc(batch_angles, sizeof(double) * 3 * batch_capacity);
+            batch_sin = realloc(batch_sin, sizeof(double) * 3 * batch_capacity);
+            batch_cos = realloc(batch_cos, sizeof(double) * 3 * batch_capacity);
+            batch_cubes = realloc(batch_cubes, sizeof(int) * batch_capacity);
+            assert(batch_angles != NULL && batch_sin != NULL && batch_cos != NULL && batch_cubes != NULL);
+        }
+        batch_cubes[count] = i;
+        batch_angles[count * 3 + 0] = pool->rot[i].x;
+        batch_angles[count * 3 + 1] = pool->rot[i].y;
+        batch_angles[count * 3 + 2] = pool->rot[i].z;
+        count++;
+    }
+    if (count == 0) return 0;
+
+    trig_sincos_batch(trig_tier, batch_angles, batch_sin, batch_cos, count * 3);
+
+    for (int b = 0; b < count; b++) {
+        int i = batch_cubes[b];
+        pool->rot_sin[i] = (v3){.x = batch_sin[b * 3 + 0], .y = batch_sin[b * 3 + 1], .z = batch_sin[b * 3 + 2]};
+        pool->rot_cos[i] = (v3){.x = batch_cos[b * 3 + 0], .y = batch_cos[b * 3 + 1], .z = batch_cos[b * 3 + 2]};
+        pool->dirty[i] &= ~DIRTY_ROTATION;
+    }
+    return count;
+}
+
+// Cubes rebuilt by each chunk of the last pool_update_models().
+static int* chunk_rebuilt = NULL;
+static int chunk_capacity = 0;
+
+typedef struct model_job {
+    cube_pool* pool;
+    int chunks;
+} model_job;
+
+static void rebuild_models(void* ctx, int first_chunk, int last_chunk, int worker) {
+    model_job* job = ctx;
+    cube_pool* pool = job->pool;
+
+    for (int chunk = first_chunk; chunk < last_chunk; chunk++) {
+        int begin, end;
+        jobs_chunk_range(pool->count, job->chunks, chunk, &begin, &end);
+
+        int rebuilt = 0;
+        for (int i = begin; i < end; i++) {
+            if (!pool->dirty[i]) continue;
+            pool->changed[begin + rebuilt++] = i;
+
+            v3 c = pool->center[i];
+            v3 e = pool->extent[i];
+            m3 r = pool->orient_models ? quat_to_m3(pool->orient[i]) : m3_rotation_xyz_sc(pool->rot_sin[i], pool->rot_cos[i]);
+
+            // m4_affine(r, c, e) without the unused last row.
+            float* m = pool->model[i].m;
+            for (int row = 0; row < 3; row++) {
+                m[row * 4 + 0] = (float)(r.m[row * 3 + 0] * e.x);
+                m[row * 4 + 1] = (float)(r.m[row * 3 + 1] * e.y);
+                m[row * 4 + 2] = (float)(r.m[row * 3 + 2] * e.z);
+            }
+            m[3] = (float)c.x;
+            m[7] = (float)c.y;
+            m[11] = (float)c.z;
+
+            pool->dirty[i] = 0;
+        }
+        chunk_rebuilt[chunk] = rebuilt;
+    }
+}
+
+int pool_update_models(cube_pool* pool) {
+    // Directly set angles pay for trig here, in one batch at the renderer's chosen accuracy.
+    // Auto-rotated cubes arrive with their sin/cos already advanced.
+    pool_sync_rotations(pool);
+
+    // Each chunk lists the cubes it rebuilt at the start of its own stretch of changed,
+    // the lists are then packed together in chunk order, so changed stays sorted.
+    int chunks = jobs_chunks_for(pool->count, POOL_GRAIN);
+    if (chunks > chunk_capacity) {
+        chunk_capacity = chunks;
+        chunk_rebuilt = realloc(chunk_rebuilt, sizeof(int) * chunk_capacity);
+        assert(chunk_rebuilt != NULL);
+    }
+    model_job job = {.pool = pool, .chunks = chunks};
+    jobs_parallel_for(chunks, chunks, rebuild_models, &job);
+
+    int rebuilt = 0;
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        int begin, end;
+        jobs_chunk_range(pool->count, chunks, chunk, &begin, &end);
+        if (rebuilt != begin) memmove(&pool->changed[rebuilt], &pool->changed[begin], sizeof(int) * chunk_rebuilt[chunk]);
+        rebuilt += chunk_rebuilt[chunk];
+    }
+    pool->changed_count = rebuilt;
+    return rebuilt;
+}
+
+bool pool_valid(const cube_pool* pool, cube_handle handle) {
+    // Freed slots have their generation bumped, so a matching generation means live.
+    return handle.slot < (Uint32)pool->slot_count && pool->generations[handle.slot] == handle.generation;
+}
+
+int pool_index(const cube_pool* pool, cube_handle handle) {
+    if (!pool_valid(pool, handle)) return -1;
+    return (int)pool->slot_to_dense[handle.slot];
+}
+
+cube_handle pool_handle_at(const cube_pool* pool, int index) {
+    if (index < 0 || index >= pool->count) return CUBE_HANDLE_NONE;
+    Uint32 slot = pool->dense_to_slot[index];
+    return (cube_handle){.slot = slot, .generation = pool->generations[slot]};
+}
@@ -0,0 +1,285 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<malloc.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<raster.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include<immintrin.h>
+#define RASTER_X86
+#endif
+
+static const char* backend_names[BACKEND_COUNT] = {
+    [BACKEND_SDL] = "sdl",
+    [BACKEND_SOFT] = "soft",
+    [BACKEND_TILED] = "tiled"
+};
+
+const char* backend_name(enum RenderBackend backend) {
+    return (backend >= 0 && backend < BACKEND_COUNT) ? backend_names[backend] : "unknown";
+}
+
+int backend_from_name(const char* name) {
+    for (int b = 0; b < BACKEND_COUNT; b++) {
+        if (SDL_strcasecmp(name, backend_names[b]) == 0) return b;
+    }
+    return -1;
+}
+
+bool raster_init(framebuffer* fb, SDL_Renderer* renderer, int width, int height) {
+    memset(fb, 0, sizeof(framebuffer));
+    fb->width = fb->max_width = width;
+    fb->height = fb->max_height = height;
+    fb->pixels = SDL_SIMDAlloc(sizeof(Uint32) * width * height);
+    if (fb->pixels == NULL) return false;
+
+    if (renderer != NULL) {
+        fb->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+        if (fb->texture == NULL) {
+            print("Could not create the framebuffer texture: %s\n", SDL_GetError());
+            return false;
+        }
+        // Covers the whole target, nothing underneath needs blending in.
+        SDL_SetTextureBlendMode(fb->texture, SDL_BLENDMODE_NONE);
+        SDL_SetTextureScaleMode(fb->texture, SDL_ScaleModeLinear);
+    }
+    return true;
+}
+
+void raster_destroy(framebuffer* fb) {
+    if (fb->texture != NULL) SDL_DestroyTexture(fb->texture);
+    SDL_SIMDFree(fb->pixels);
+    memset(fb, 0, sizeof(framebuffer));
+}
+
+void raster_resize(framebuffer* fb, int width, int height) {
+    assert(width > 0 && height > 0 && width <= fb->max_width && height <= fb->max_height);
+    fb->width = width;
+    fb->height = height;
+}
+
+void raster_clear(framebuffer* fb, Uint32 argb) {
+    SDL_memset4(fb->pixels, argb, (size_t)fb->width * fb->height);
+}
+
+// Fills `count` pixels from `p` on, one implementation per kernel variant.
+typedef void (*fill_fn)(Uint32* p, Uint32 argb, int count);
+
+static inline void fill_scalar(Uint32* p, Uint32 argb, int count) {
+    SDL_memset4(p, argb, count);
+}
+
+static inline void span_h(framebuffer* fb, int y, int x1, int x2, Uint32 argb, fill_fn fill) {
+    if (x1 > x2) {
+        int swap = x1;
+        x1 = x2;
+        x2 = swap;
+    }
+    fill(&fb->pixels[y * fb->width + x1], argb, x2 - x1 + 1);
+}
+
+static inline void span_v(framebuffer* fb, int x, int y1, int y2, Uint32 argb) {
+    if (y1 > y2) {
+        int swap = y1;
+        y1 = y2;
+        y2 = swap;
+    }
+    Uint32* p = &fb->pixels[y1 * fb->width + x];
+    for (int y = y1; y <= y2; y++) {
+        *p = argb;
+        p += fb->width;
+    }
+}
+
+static int clamp_int(int v, int lo, int hi) {
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+// Horizontal runs of shallow lines shorter than this, on average, are drawn pixel by pixel anyway.
+#define LINE_MIN_RUN 4
+
+// Shared by every variant, `fill` is what they differ in. Inlined into each, so it gets built for
+// the variant's instruction set and `fill` becomes a direct call.
+// With `runs` set, x-major lines are drawn a horizontal run at a time instead of pixel by pixel.
+static inline __attribute__((always_inline)) void line_rect(
+    framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect, fill_fn fill, bool runs
+) {
+    int rx2 = rect.x + rect.w - 1;
+    int ry2 = rect.y + rect.h - 1;
+
+    if (y1 == y2) {
+        if (y1 < rect.y || y1 > ry2) return;
+        int lo = clamp_int((x1 < x2) ? x1 : x2, rect.x, rx2);
+        int hi = clamp_int((x1 < x2) ? x2 : x1, rect.x, rx2);
+        if ((x1 < rect.x && x2 < rect.x) || (x1 > rx2 && x2 > rx2)) return;
+        span_h(fb, y1, lo, hi, argb, fill);
+        return;
+    }
+    if (x1 == x2) {
+        if (x1 < rect.x || x1 > rx2) return;
+        int lo = clamp_int((y1 < y2) ? y1 : y2, rect.y, ry2);
+        int hi = clamp_int((y1 < y2) ? y2 : y1, rect.y, ry2);
+        if ((y1 < rect.y && y2 < rect.y) || (y1 > ry2 && y2 > ry2)) return;
+        span_v(fb, x1, lo, hi, argb);
+        return;
+    }
+
+    // Step i along the major axis puts the minor coordinate at round(i * minor / major), half up.
+    // Being a closed form, any stretch of the line can start at any step and still land on
+    // exactly the pixels the whole line would, which is what lets tiles draw their part alone.
+    bool x_major = abs(x2 - x1) >= abs(y2 - y1);
+    int a1 = x_major ? x1 : y1;
+    int a2 = x_major ? x2 : y2;
+    int b1 = x_major ? y1 : x1;
+    int b2 = x_major ? y2 : x2;
+    int a_lo = x_major ? rect.x : rect.y;
+    int a_hi = x_major ? rx2 : ry2;
+    int b_lo = x_major ? rect.y : rect.x;
+    int b_hi = x_major ? ry2 : rx2;
+
+    int n = abs(a2 - a1);
+    int da = (a2 > a1) ? 1 : -1;
+    int db = (b2 > b1) ? 1 : -1;
+    long long adb = abs(b2 - b1);
+
+    // Steps whose major coordinate lies within the rectangle.
+    int i_first = (da > 0) ? a_lo - a1 : a1 - a_hi;
+    int i_last = (da > 0) ? a_hi - a1 : a1 - a_lo;
+    if (i_first < 0) i_first = 0;
+    if (i_last > n) i_last = n;
+    if (i_first > i_last) return;
+
+    long long den = 2LL * n;
+    long long num = 2LL * i_first * adb + n;
+    int q = (int)(num / den);
+    long long r = num % den;
+    int a = a1 + da * i_first;
+    int b = b1 + db * q;
+
+    // The minor coordinate of an x-major line moves by at most one per step, so the line is a row of
+    // horizontal runs, each lasting as long as the remainder takes to reach den. All but the first
+    // are `run` or `run` + 1 pixels long. Short ones are left to the pixel walk, a fill does not pay.
+    long long run = (den - 1) / (2 * adb);
+    if (runs && x_major && run >= LINE_MIN_RUN) {
+        long long longer_below = (den - 1) % (2 * adb);
+        int length = (int)((den - 1 - r) / (2 * adb)) + 1;
+        for (int i = i_first; i <= i_last;) {
+            if (length > i_last - i + 1) length = i_last - i + 1;
+            if (b >= b_lo && b <= b_hi) {
+                int left = (da > 0) ? a : a - (length - 1);
+                fill(&fb->pixels[b * fb->width + left], argb, length);
+            }
+
+            i += length;
+            a += da * length;
+            r += 2 * adb * length;
+            if (r >= den) {
+                r -= den;
+                b += db;
+            }
+            length = (int)((r <= longer_below) ? run + 1 : run);
+        }
+        return;
+    }
+
+    // Walk a pixel pointer, one stride per axis.
+    int stride_a = x_major ? da : da * fb->width;
+    int stride_b = x_major ? db * fb->width : db;
+    Uint32* p = x_major ? &fb->pixels[b * fb->width + a] : &fb->pixels[a * fb->width + b];
+    for (int i = i_first; i <= i_last; i++) {
+        if (b >= b_lo && b <= b_hi) *p = argb;
+
+        p += stride_a;
+        r += 2 * adb;
+        if (r >= den) {
+            r -= den;
+            b += db;
+            p += stride_b;
+        }
+    }
+}
+
+void raster_line_scalar(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect) {
+    line_rect(fb, x1, y1, x2, y2, argb, rect, fill_scalar, false);
+}
+
+#ifdef RASTER_X86
+
+__attribute__((target("sse2")))
+static inline void fill_sse2(Uint32* p, Uint32 argb, int count) {
+    __m128i v = _mm_set1_epi32((int)argb);
+    int k = 0;
+    for (; k + 4 <= count; k += 4) {
+        _mm_storeu_si128((__m128i*)&p[k], v);
+    }
+    for (; k < count; k++) {
+        p[k] = argb;
+    }
+}
+
+__attribute__((target("avx2")))
+static inline void fill_avx2(Uint32* p, Uint32 argb, int count) {
+    __m256i v = _mm256_set1_epi32((int)argb);
+    int k = 0;
+    for (; k + 8 <= count; k += 8) {
+        _mm256_storeu_si256((__m256i*)&p[k], v);
+    }
+    if (k + 4 <= count) {
+        _mm_storeu_si128((__m128i*)&p[k], _mm256_castsi256_si128(v));
+        k += 4;
+    }
+    for (; k < count; k++) {
+        p[k] = argb;
+    }
+}
+
+__attribute__((target("sse2")))
+void raster_line_sse2(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect) {
+    line_rect(fb, x1, y1, x2, y2, argb, rect, fill_sse2, true);
+}
+
+__attribute__((target("avx2")))
+void raster_line_avx2(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect) {
+    line_rect(fb, x1, y1, x2, y2, argb, rect, fill_avx2, true);
+}
+
+#else
+
+void raster_line_sse2(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect) {
+    raster_line_scalar(fb, x1, y1, x2, y2, argb, rect);
+}
+
+void raster_line_avx2(framebuffer* fb, int x1, int y1, int x2, int y2, Uint32 argb, SDL_Rect rect) {
+    raster_line_scalar(fb, x1, y1, x2, y2, argb, rect);
+}
+
+#endif // RASTER_X86
+
+int raster_present(framebuffer* fb, SDL_Renderer* renderer) {
+    // Only the part of the texture in use is uploaded and stretched over the target.
+    SDL_Rect used = {.x = 0, .y = 0, .w = fb->width, .h = fb->height};
+    void* texels;
+    int pitch;
+    if (SDL_LockTexture(fb->texture, &used, &texels, &pitch) != 0) {
+        print("Could not lock the framebuffer texture: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    size_t row = sizeof(Uint32) * fb->width;
+    if ((size_t)pitch == row) {
+        memcpy(texels, fb->pixels, row * fb->height);
+    } else {
+        for (int y = 0; y < fb->height; y++) {
+            memcpy((Uint8*)texels + (size_t)y * pitch, &fb->pixels[y * fb->width], row);
+        }
+    }
+    SDL_UnlockTexture(fb->texture);
+
+    SDL_RenderCopy(renderer, fb->texture, &used, NULL);
+    return 1;
+}
@@ -0,0 +1,525 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<assert.h>
+#include<malloc.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<pool.h>
+#include<jobs.h>
+#include<lockfree.h>
+#include<sim.h>
+
+// Load, tick cost over tick length, above which the simulation counts as overloaded, and below
+// which, at the next higher rate, it counts as having room again.
+#define SIM_LOAD_HIGH 0.75
+#define SIM_LOAD_LOW 0.4
+// Seconds of sustained overload before the rate is lowered, and of sustained room before it is raised.
+#define SIM_STRAIN_SECONDS 0.25
+#define SIM_RELAX_SECONDS 0.5
+// Factor the tick length changes by per adjustment, and the most it may grow over the one asked for.
+#define SIM_RATE_STEP 1.25
+#define SIM_MAX_STRETCH 4.0
+// Longest the simulation rests without a command before it ticks once more to look again.
+#define SIM_REST_TIMEOUT_MS 500
+
+static double base_dt = 0.0;    // Tick length asked for
+static double tick_dt = 0.0;    // Tick length in use, longer than base_dt under sustained load
+static sim_update_fn update_fn = NULL;
+static sim_command_fn command_fn = NULL;
+
+// Owned by the simulation thread while it runs.
+static cube_pool pool;
+static cube_handle selected;
+static Uint64 ticks = 0;
+static Uint64 published = 0;
+static Uint64 tick_stamp = 0;
+static double sim_time = 0.0;
+
+// Catch-up policy, see sim_main().
+static int max_steps = SIM_MAX_STEPS;
+static double tick_cost = 0.0;  // Seconds a tick takes, moving average
+static double strained = 0.0;   // Seconds of simulated time overloaded in a row
+static double relaxed = 0.0;    // Seconds of simulated time with room to spare in a row
+static double dropped = 0.0;
+
+// What the last published snapshot showed, beyond the cubes' own dirty bits.
+static Uint32 shown_layout = 0;
+static int shown_selected = -1;
+static double shown_dt = 0.0;
+static double shown_dropped = 0.0;
+
+// SDL event pushed on every publish, 0 for none.
+static Uint32 notify_event = 0;
+
+static scene_snapshot snapshots[3];
+static triple_buffer handoff;
+static int back = 0;
+static spsc_queue commands;
+// Posted with every command, a resting simulation waits on it.
+static SDL_sem* wake = NULL;
+
+static SDL_Thread* thread = NULL;
+static SDL_atomic_t stopping;
+
+// Renderer side of sim_mirror() and sim_blend(), indexed like the newest mirrored snapshot.
+static cube_handle* mirror_handles = NULL;
+static int mirror_capacity = 0;
+static int mirror_count = 0;
+static Uint64 mirror_serial = 0;
+static Uint32 mirror_layout = 0;
+static bool mirrored = false;
+
+// State of the cubes as of one mirrored snapshot.
+typedef struct mirror_state {
+    v3* center;
+    v3* extent;
+    quat* orient;
+    double time;
+} mirror_state;
+
+// The two newest mirrored snapshots, sim_blend() goes from one to the other.
+static mirror_state from;
+static mirror_state to;
+static Uint64 to_stamp = 0;
+
+enum BlendState {
+    BLEND_SETTLED,  // The pool already shows the newest state
+    BLEND_LAST,     // Stopped moving, the newest state still has to be written once
+    BLEND_MOVING    // Differs between the two snapshots
+};
+static Uint8* blending = NULL;
+
+// Snapshot cubes per chunk below which mirroring is not worth handing to another thread.
+#define MIRROR_GRAIN 2048
+
+void sim_init(double dt, sim_update_fn update, sim_command_fn command) {
+    base_dt = tick_dt = dt;
+    update_fn = update;
+    command_fn = command;
+
+    pool_init(&pool, 2);
+    selected = CUBE_HANDLE_NONE;
+    ticks = published = 0;
+    sim_time = 0.0;
+    tick_cost = strained = relaxed = dropped = 0.0;
+    memset(snapshots, 0, sizeof(snapshots));
+    triple_init(&handoff);
+    back = handoff.back;
+    assert(spsc_init(&commands, sizeof(sim_command), SIM_QUEUE_SIZE));
+    wake = SDL_CreateSemaphore(0);
+    assert(wake != NULL);
+    SDL_AtomicSet(&stopping, 0);
+    mirrored = false;
+    mirror_count = 0;
+}
+
+void sim_destroy() {
+    sim_stop();
+    for (int k = 0; k < 3; k++) {
+        scene_snapshot* snap = &snapshots[k];
+        free(snap->center);
+        free(snap->extent);
+        free(snap->rot);
+        free(snap->rot_sin);
+        free(snap->rot_cos);
+        free(snap->mesh);
+    }
+    memset(snapshots, 0, sizeof(snapshots));
+    spsc_destroy(&commands);
+    SDL_DestroySemaphore(wake);
+    wake = NULL;
+    pool_destroy(&pool);
+    free(mirror_handles);
+    free(from.center);
+    free(from.extent);
+    free(from.orient);
+    free(to.center);
+    free(to.extent);
+    free(to.orient);
+    free(blending);
+    mirror_handles = NULL;
+    blending = NULL;
+    memset(&from, 0, sizeof(mirror_state));
+    memset(&to, 0, sizeof(mirror_state));
+    mirror_capacity = 0;
+}
+
+void sim_set_notify(Uint32 event_type) {
+    notify_event = event_type;
+}
+
+void sim_set_max_steps(int steps) {
+    max_steps = (steps > 0) ? steps : 1;
+}
+
+cube_pool* sim_pool() {
+    return &pool;
+}
+
+cube_handle* sim_selected() {
+    return &selected;
+}
+
+static void take_snapshot(scene_snapshot* snap) {
+    if (pool.count > snap->capacity) {
+        snap->capacity = pool.count * 2;
+        snap->center = realloc(snap->center, sizeof(v3) * snap->capacity);
+        snap->extent = realloc(snap->extent, sizeof(v3) * snap->capacity);
+        snap->rot = realloc(snap->rot, sizeof(v3) * snap->capacity);
+        snap->rot_sin = realloc(snap->rot_sin, sizeof(v3) * snap->capacity);
+        snap->rot_cos = realloc(snap->rot_cos, sizeof(v3) * snap->capacity);
+        snap->mesh = realloc(snap->mesh, sizeof(wire_mesh*) * snap->capacity);
+        assert(snap->center != NULL && snap->extent != NULL && snap->rot != NULL);
+        assert(snap->rot_sin != NULL && snap->rot_cos != NULL && snap->mesh != NULL);
+    }
+
+    // Directly set angles get their sin/cos here, at the renderer's chosen trig tier, as the
+    // simulation never builds models itself.
+    pool_sync_rotations(&pool);
+    memset(pool.dirty, 0, sizeof(Uint8) * pool.count);
+
+    size_t size = sizeof(v3) * pool.count;
+    memcpy(snap->center, pool.center, size);
+    memcpy(snap->extent, pool.extent, size);
+    memcpy(snap->rot, pool.rot, size);
+    memcpy(snap->rot_sin, pool.rot_sin, size);
+    memcpy(snap->rot_cos, pool.rot_cos, size);
+    memcpy(snap->mesh, pool.mesh, sizeof(wire_mesh*) * pool.count);
+    snap->count = pool.count;
+    snap->serial = ++published;
+    snap->tick = ticks;
+    snap->time = sim_time;
+    snap->stamp = tick_stamp;
+    snap->dt = tick_dt;
+    snap->dropped = dropped;
+    snap->layout_version = pool.layout_version;
+    snap->selected = pool_index(&pool, selected);
+
+    shown_layout = snap->layout_version;
+    shown_selected = snap->selected;
+    shown_dt = snap->dt;
+    shown_dropped = snap->dropped;
+}
+
+static void publish() {
+    take_snapshot(&snapshots[back]);
+    back = triple_publish(&handoff);
+
+    if (notify_event != 0) {
+        SDL_Event event = {.type = notify_event};
+        SDL_PushEvent(&event);
+    }
+}
+
+// Whether the snapshot would differ from the last one published. Ticks that moved nothing are not
+// published, so a scene at rest costs the renderer nothing either.
+static bool scene_touched() {
+    if (pool.layout_version != shown_layout || pool_index(&pool, selected) != shown_selected) return true;
+    if (tick_dt != shown_dt || dropped != shown_dropped) return true;
+    for (int i = 0; i < pool.count; i++) {
+        if (pool.dirty[i]) return true;
+    }
+    return false;
+}
+
+// Returns whether any command was applied.
+static bool apply_commands() {
+    sim_command cmd;
+    bool any = false;
+    while (spsc_pop(&commands, &cmd)) {
+        command_fn(&pool, &selected, &cmd);
+        any = true;
+    }
+    return any;
+}
+
+// Lowers the tick rate after sustained overload and raises it back after sustained room, with
+// separate thresholds and durations for both so it settles instead of oscillating.
+static void adapt_rate(bool behind, double ran) {
+    double load = tick_cost / tick_dt;
+    if (behind || load > SIM_LOAD_HIGH) {
+        relaxed = 0.0;
+        strained += ran;
+        if (strained >= SIM_STRAIN_SECONDS && tick_dt < base_dt * SIM_MAX_STRETCH) {
+            tick_dt = fmin(tick_dt * SIM_RATE_STEP, base_dt * SIM_MAX_STRETCH);
+            strained = 0.0;
+        }
+    } else if (tick_dt > base_dt && load * SIM_RATE_STEP < SIM_LOAD_LOW) {
+        strained = 0.0;
+        relaxed += ran;
+        if (relaxed >= SIM_RELAX_SECONDS) {
+            tick_dt = fmax(tick_dt / SIM_RATE_STEP, base_dt);
+            relaxed = 0.0;
+        }
+    } else {
+        strained = relaxed = 0.0;
+    }
+}
+
+static int sim_main(void* data) {
+    // Ticks may use parallel loops too.
+    jobs_attach();
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 next = SDL_GetPerformanceCounter() + (Uint64)(tick_dt * frequency);
+
+    while (!SDL_AtomicGet(&stopping)) {
+        bool commanded = apply_commands();
+        bool ran_any = commanded;
+
+        // Catches up on at most max_steps ticks per pass. Past that, running more would only make
+        // the next pass later still, so the rest of the backlog is given up instead.
+        Uint64 now = SDL_GetPerformanceCounter();
+        int steps = 0;
+        double ran = 0.0;
+        while (now >= next && steps < max_steps) {
+            update_fn(&pool, tick_dt);
+            Uint64 after = SDL_GetPerformanceCounter();
+            tick_cost += ((double)(after - now) / frequency - tick_cost) * 0.125;
+            now = after;
+
+            ticks++;
+            steps++;
+            ran += tick_dt;
+            sim_time += tick_dt;
+            tick_stamp = next;
+            next += (Uint64)(tick_dt * frequency);
+            ran_any = true;
+        }
+
+        bool behind = now >= next;
+        if (behind) {
+            Uint64 step = (Uint64)(tick_dt * frequency);
+            Uint64 skipped = (now - next) / step + 1;
+            dropped += skipped * tick_dt;
+            next += skipped * step;
+            // What was simulated stands for now, not for when the last tick was due.
+            tick_stamp = next - step;
+        }
+        if (steps > 0) adapt_rate(behind, ran);
+        if (ran_any && scene_touched()) {
+            publish();
+        } else if (steps > 0 && !commanded) {
+            // Ticks that move nothing keep moving nothing until a command changes something, so
+            // instead of ticking on, the simulation waits for one.
+            SDL_SemWaitTimeout(wake, SIM_REST_TIMEOUT_MS);
+            // Time spent resting is neither simulated nor dropped, ticking picks up from here.
+            next = tick_stamp = SDL_GetPerformanceCounter();
+            continue;
+        }
+
+        // Sleeps until the next tick is due, commands are picked up then. Rounded up, as a
+        // shorter sleep would leave the rest of the wait to spin through this loop.
+        now = SDL_GetPerformanceCounter();
+        if (next > now) SDL_Delay((Uint32)(((next - now) * 1000 + frequency - 1) / frequency));
+    }
+    return 0;
+}
+
+void sim_start() {
+    tick_stamp = SDL_GetPerformanceCounter();
+    publish();
+    SDL_AtomicSet(&stopping, 0);
+    thread = SDL_CreateThread(sim_main, "simulation", NULL);
+    assert(thread != NULL);
+}
+
+void sim_stop() {
+    if (thread == NULL) return;
+    SDL_AtomicSet(&stopping, 1);
+    SDL_SemPost(wake);
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+}
+
+bool sim_send(sim_command cmd) {
+    if (!spsc_push(&commands, &cmd)) return false;
+    SDL_SemPost(wake);
+    return true;
+}
+
+const scene_snapshot* sim_latest() {
+    return &snapshots[triple_acquire(&handoff)];
+}
+
+static void reserve_mirror(int count) {
+    if (count <= mirror_capacity) return;
+
+    mirror_capacity = count * 2;
+    mirror_handles = realloc(mirror_handles, sizeof(cube_handle) * mirror_capacity);
+    blending = realloc(blending, sizeof(Uint8) * mirror_capacity);
+    assert(mirror_handles != NULL && blending != NULL);
+    mirror_state* states[2] = {&from, &to};
+    for (int k = 0; k < 2; k++) {
+        mirror_state* state = states[k];
+        state->center = realloc(state->center, sizeof(v3) * mirror_capacity);
+        state->extent = realloc(state->extent, sizeof(v3) * mirror_capacity);
+        state->orient = realloc(state->orient, sizeof(quat) * mirror_capacity);
+        assert(state->center != NULL && state->extent != NULL && state->orient != NULL);
+    }
+}
+
+typedef struct mirror_job {
+    const scene_snapshot* snap;
+    cube_pool* pool;
+    bool relayout;
+    double alpha;
+    int stride;     // sim_blend_part() only blends moving cubes whose index is phase modulo stride
+    int phase;
+    SDL_atomic_t counted;
+    SDL_atomic_t owed;  // Moving cubes it left for another phase
+} mirror_job;
+
+// Takes snapshot cubes [begin, end) as the newest state and works out which of them move.
+static void capture_range(void* ctx, int begin, int end, int worker) {
+    mirror_job* job = ctx;
+    const scene_snapshot* snap = job->snap;
+    cube_pool* p = job->pool;
+
+    int moved = 0;
+    for (int s = begin; s < end; s++) {
+        to.center[s] = snap->center[s];
+        to.extent[s] = snap->extent[s];
+        to.orient[s] = quat_from_m3(m3_rotation_xyz_sc(snap->rot_sin[s], snap->rot_cos[s]));
+        // Angles are only shown, models are built from orient.
+        p->rot[pool_index(p, mirror_handles[s])] = snap->rot[s];
+        if (job->relayout) continue;
+
+        bool moving = memcmp(&from.center[s], &to.center[s], sizeof(v3)) != 0
+            || memcmp(&from.extent[s], &to.extent[s], sizeof(v3)) != 0
+            || memcmp(&from.orient[s], &to.orient[s], sizeof(quat)) != 0;
+        if (moving) {
+            blending[s] = BLEND_MOVING;
+            moved++;
+        } else if (blending[s] != BLEND_SETTLED) {
+            // The pool still shows a blend towards what is now the newest state.
+            blending[s] = BLEND_LAST;
+        }
+    }
+    SDL_AtomicAdd(&job->counted, moved);
+}
+
+int sim_mirror(const scene_snapshot* snap, cube_pool* p) {
+    if (mirrored && snap->serial == mirror_serial) return 0;
+
+    bool relayout = !mirrored || snap->layout_version != mirror_layout;
+    if (relayout) {
+        // Cubes came or went, start over. The new layout sends the BVH and Morton order into a rebuild.
+        reserve_mirror(snap->count);
+        pool_clear(p);
+        p->orient_models = true;
+        for (int s = 0; s < snap->count; s++) {
+            mirror_handles[s] = pool_add(p, NULL);
+        }
+    } else {
+        mirror_state older = from;
+        from = to;
+        to = older;
+    }
+    to.time = snap->time;
+    to_stamp = snap->stamp;
+    // Nothing is published while nothing moves, so the previous snapshot may be much older than
+    // the tick before this one. Its state still held right up to that tick though.
+    if (to.time - from.time > snap->dt) from.time = to.time - snap->dt;
+    mirror_count = snap->count;
+
+    mirror_job job = {.snap = snap, .pool = p, .relayout = relayout};
+    SDL_AtomicSet(&job.counted, 0);
+    jobs_parallel_for(snap->count, jobs_chunks_for(snap->count, MIRROR_GRAIN), capture_range, &job);
+    int moved = SDL_AtomicGet(&job.counted);
+
+    if (relayout) {
+        // Nothing to blend from, the first frame shows the snapshot as is.
+        memcpy(from.center, to.center, sizeof(v3) * snap->count);
+        memcpy(from.extent, to.extent, sizeof(v3) * snap->count);
+        memcpy(from.orient, to.orient, sizeof(quat) * snap->count);
+        from.time = to.time;
+        memset(blending, BLEND_SETTLED, snap->count);
+        for (int s = 0; s < snap->count; s++) {
+            int i = pool_index(p, mirror_handles[s]);
+            p->center[i] = to.center[s];
+            p->extent[i] = to.extent[s];
+            p->orient[i] = to.orient[s];
+            p->mesh[i] = snap->mesh[s];
+            p->dirty[i] = DIRTY_MODEL;
+        }
+        moved = snap->count;
+        mirrored = true;
+        mirror_layout = snap->layout_version;
+    }
+    mirror_serial = snap->serial;
+    return moved;
+}
+
+bool sim_fresh() {
+    return triple_fresh(&handoff) || !mirrored || snapshots[handoff.front].serial != mirror_serial;
+}
+
+double sim_alpha() {
+    double span = to.time - from.time;
+    if (!mirrored || span <= 0.0) return 1.0;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now <= to_stamp) return 0.0;
+    double alpha = (double)(now - to_stamp) / SDL_GetPerformanceFrequency() / span;
+    return (alpha < 1.0) ? alpha : 1.0;
+}
+
+static v3 v_lerp(v3 a, v3 b, double t) {
+    return (v3){
+        .x = a.x + (b.x - a.x) * t,
+        .y = a.y + (b.y - a.y) * t,
+        .z = a.z + (b.z - a.z) * t
+    };
+}
+
+static void blend_range(void* ctx, int begin, int end, int worker) {
+    mirror_job* job = ctx;
+    cube_pool* p = job->pool;
+    double alpha = job->alpha;
+
+    int written = 0;
+    int owed = 0;
+    for (int s = begin; s < end; s++) {
+        if (blending[s] == BLEND_SETTLED) continue;
+        // Cubes coming to rest are always written, it is their last write until the next snapshot.
+        if (blending[s] == BLEND_MOVING && s % job->stride != job->phase) {
+            owed++;
+            continue;
+        }
+
+        int i = pool_index(p, mirror_handles[s]);
+        if (blending[s] == BLEND_MOVING && alpha < 1.0) {
+            p->center[i] = v_lerp(from.center[s], to.center[s], alpha);
+            p->extent[i] = v_lerp(from.extent[s], to.extent[s], alpha);
+            p->orient[i] = quat_slerp(from.orient[s], to.orient[s], alpha);
+        } else {
+            // Caught up, nothing changes until the next snapshot.
+            p->center[i] = to.center[s];
+            p->extent[i] = to.extent[s];
+            p->orient[i] = to.orient[s];
+            blending[s] = BLEND_SETTLED;
+        }
+        p->dirty[i] |= DIRTY_MODEL;
+        written++;
+    }
+    SDL_AtomicAdd(&job->counted, written);
+    SDL_AtomicAdd(&job->owed, owed);
+}
+
+int sim_blend(cube_pool* p, double alpha) {
+    return sim_blend_part(p, alpha, 1, 0, NULL);
+}
+
+int sim_blend_part(cube_pool* p, double alpha, int stride, int phase, int* owed) {
+    if (stride < 1) stride = 1;
+    mirror_job job = {.pool = p, .alpha = alpha, .stride = stride, .phase = phase % stride};
+    SDL_AtomicSet(&job.counted, 0);
+    SDL_AtomicSet(&job.owed, 0);
+    jobs_parallel_for(mirror_count, jobs_chunks_for(mirror_count, MIRROR_GRAIN), blend_range, &job);
+    if (owed != NULL) *owed = SDL_AtomicGet(&job.owed);
+    return SDL_AtomicGet(&job.counted);
+}
@@ -0,0 +1,288 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<stdarg.h>
+#include<string.h>
+#include<assert.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<jobs.h>
+#include<taskgraph.h>
+
+static FILE* trace = NULL;
+static bool trace_first = true;
+static Uint64 trace_origin = 0;
+static int trace_flow = 0;
+
+bool tgraph_init(task_graph* graph) {
+    memset(graph, 0, sizeof(task_graph));
+    graph->main_wake = SDL_CreateSemaphore(0);
+    return graph->main_wake != NULL;
+}
+
+void tgraph_destroy(task_graph* graph) {
+    if (graph->main_wake != NULL) SDL_DestroySemaphore(graph->main_wake);
+    memset(graph, 0, sizeof(task_graph));
+}
+
+void tgraph_reset(task_graph* graph) {
+    graph->count = 0;
+}
+
+int tgraph_add(task_graph* graph, const char* name, enum TaskAffinity affinity, task_fn fn, void* ctx) {
+    assert(graph->count < TGRAPH_MAX_TASKS);
+    int id = graph->count++;
+    task* t = &graph->tasks[id];
+    t->name = name;
+    t->fn = fn;
+    t->ctx = ctx;
+    t->affinity = affinity;
+    t->graph = graph;
+    t->dep_count = 0;
+    t->dependent_count = 0;
+    t->worker = -1;
+    t->start = t->end = 0;
+    return id;
+}
+
+void tgraph_depend(task_graph* graph, int id, int on) {
+    assert(on < id && id < graph->count);
+    task* t = &graph->tasks[id];
+    assert(t->dep_count < TGRAPH_MAX_DEPS);
+    t->deps[t->dep_count++] = on;
+    task* before = &graph->tasks[on];
+    before->dependents[before->dependent_count++] = id;
+}
+
+static const char* frame_task_names[FRAME_TASK_COUNT] = {
+    [FRAME_EVENTS] = "events",
+    [FRAME_SYNC] = "sync",
+    [FRAME_MODELS] = "models",
+    [FRAME_TRANSFORM] = "transform",
+    [FRAME_LINES] = "lines",
+    [FRAME_RASTER] = "raster",
+    [FRAME_HUD] = "hud",
+    [FRAME_HUD_DRAW] = "hud draw",
+    [FRAME_DRAW] = "draw",
+    [FRAME_PRESENT] = "present"
+};
+
+static const enum TaskAffinity frame_task_affinities[FRAME_TASK_COUNT] = {
+    [FRAME_EVENTS] = TASK_MAIN,
+    [FRAME_HUD_DRAW] = TASK_MAIN,
+    [FRAME_DRAW] = TASK_MAIN,
+    [FRAME_PRESENT] = TASK_MAIN
+};
+
+// events > sync > models > transform > lines > raster > draw > present
+//                          > hud > hud_draw ----------------^
+// The HUD is formatted while cubes are transformed and turned into lines, and drawn into its layer
+// by the main thread meanwhile. Renderer calls all stay on the main thread.
+void tgraph_frame(task_graph* graph, const task_fn* fns, void* ctx) {
+    tgraph_reset(graph);
+    for (int t = 0; t < FRAME_TASK_COUNT; t++) {
+        tgraph_add(graph, frame_task_names[t], frame_task_affinities[t], fns[t], ctx);
+    }
+
+    tgraph_depend(graph, FRAME_SYNC, FRAME_EVENTS);
+    tgraph_depend(graph, FRAME_MODELS, FRAME_SYNC);
+    tgraph_depend(graph, FRAME_TRANSFORM, FRAME_MODELS);
+    tgraph_depend(graph, FRAME_LINES, FRAME_TRANSFORM);
+    tgraph_depend(graph, FRAME_RASTER, FRAME_LINES);
+    tgraph_depend(graph, FRAME_HUD, FRAME_MODELS);
+    tgraph_depend(graph, FRAME_HUD_DRAW, FRAME_HUD);
+    tgraph_depend(graph, FRAME_DRAW, FRAME_RASTER);
+    // The HUD layer is a render target, switch to it and back before anything is drawn to the window.
+    tgraph_depend(graph, FRAME_DRAW, FRAME_HUD_DRAW);
+    tgraph_depend(graph, FRAME_PRESENT, FRAME_DRAW);
+}
+
+static void make_ready(task_graph* graph, int id);
+
+static void run_task(task_graph* graph, int id, int worker) {
+    task* t = &graph->tasks[id];
+    t->worker = worker;
+    t->start = SDL_GetPerformanceCounter();
+    t->fn(t->ctx);
+    t->end = SDL_GetPerformanceCounter();
+
+    for (int d = 0; d < t->dependent_count; d++) {
+        int next = t->dependents[d];
+        if (SDL_AtomicAdd(&graph->tasks[next].pending, -1) == 1) make_ready(graph, next);
+    }
+    // Last one out wakes the main thread, which may be asleep waiting for it.
+    if (SDL_AtomicAdd(&graph->unfinished, -1) == 1) SDL_SemPost(graph->main_wake);
+}
+
+static void task_job(void* ctx, int begin, int end, int worker) {
+    task* t = ctx;
+    run_task(t->graph, (int)(t - t->graph->tasks), worker);
+}
+
+static void make_ready(task_graph* graph, int id) {
+    if (graph->tasks[id].affinity == TASK_MAIN) {
+        int at = SDL_AtomicAdd(&graph->main_tail, 1);
+        graph->main_ready[at] = id;
+        SDL_AtomicSet(&graph->main_published[at], 1);
+        SDL_SemPost(graph->main_wake);
+    } else {
+        jobs_spawn(task_job, &graph->tasks[id]);
+    }
+}
+
+// Next ready main thread task, -1 when there is none yet.
+static int pop_main(task_graph* graph) {
+    if (graph->main_head >= SDL_AtomicGet(&graph->main_tail)) return -1;
+    // Claimed but not written yet.
+    if (!SDL_AtomicGet(&graph->main_published[graph->main_head])) return -1;
+    return graph->main_ready[graph->main_head++];
+}
+
+void tgraph_run(task_graph* graph) {
+    assert(jobs_current_worker() == 0);
+    graph->start = graph->end = SDL_GetPerformanceCounter();
+    if (graph->count == 0) return;
+
+    // Wake-ups left over from the last run.
+    while (SDL_SemTryWait(graph->main_wake) == 0);
+    for (int i = 0; i < graph->count; i++) {
+        SDL_AtomicSet(&graph->tasks[i].pending, graph->tasks[i].dep_count);
+        SDL_AtomicSet(&graph->main_published[i], 0);
+    }
+    SDL_AtomicSet(&graph->unfinished, graph->count);
+    SDL_AtomicSet(&graph->main_tail, 0);
+    graph->main_head = 0;
+
+    for (int i = 0; i < graph->count; i++) {
+        if (graph->tasks[i].dep_count == 0) make_ready(graph, i);
+    }
+
+    // The main thread runs its own tasks first and helps the pool otherwise.
+    while (SDL_AtomicGet(&graph->unfinished) > 0) {
+        int id = pop_main(graph);
+        if (id >= 0) {
+            run_task(graph, id, 0);
+            continue;
+        }
+        if (jobs_help()) continue;
+        SDL_SemWait(graph->main_wake);
+    }
+    graph->end = SDL_GetPerformanceCounter();
+}
+
+static double ticks_ms(Uint64 ticks) {
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+double tgraph_ms(const task_graph* graph) {
+    return ticks_ms(graph->end - graph->start);
+}
+
+int tgraph_critical_path(const task_graph* graph, int* path, double* ms) {
+    // Tasks only depend on earlier ones, so one pass in order sees every chain's head first.
+    double longest[TGRAPH_MAX_TASKS];
+    int previous[TGRAPH_MAX_TASKS];
+    int last = -1;
+    for (int i = 0; i < graph->count; i++) {
+        const task* t = &graph->tasks[i];
+        longest[i] = 0.0;
+        previous[i] = -1;
+        for (int d = 0; d < t->dep_count; d++) {
+            int dep = t->deps[d];
+            if (previous[i] < 0 || longest[dep] > longest[i]) {
+                longest[i] = longest[dep];
+                previous[i] = dep;
+            }
+        }
+        longest[i] += ticks_ms(t->end - t->start);
+        if (last < 0 || longest[i] > longest[last]) last = i;
+    }
+
+    *ms = (last >= 0) ? longest[last] : 0.0;
+    int length = 0;
+    for (int i = last; i >= 0; i = previous[i]) length++;
+    int at = length;
+    for (int i = last; i >= 0; i = previous[i]) path[--at] = i;
+    return length;
+}
+
+static void trace_event(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    fputs(trace_first ? "\n" : ",\n", trace);
+    vfprintf(trace, format, args);
+    va_end(args);
+    trace_first = false;
+}
+
+static double trace_us(Uint64 ticks) {
+    return (double)(ticks - trace_origin) * 1e6 / (double)SDL_GetPerformanceFrequency();
+}
+
+bool tgraph_trace_open(const char* path) {
+    trace = fopen(path, "w");
+    if (trace == NULL) {
+        print("Could not open \"%s\" for the trace.\n", path);
+        return false;
+    }
+    trace_first = true;
+    trace_origin = SDL_GetPerformanceCounter();
+    trace_flow = 0;
+    fputs("{\"traceEvents\":[", trace);
+
+    for (int i = 0; i < jobs_thread_count(); i++) {
+        trace_event(
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+            i, (i == 0) ? "main" : "worker", i
+        );
+    }
+    return true;
+}
+
+void tgraph_trace_frame(const task_graph* graph, int frame) {
+    if (trace == NULL || graph->count == 0) return;
+
+    int path[TGRAPH_MAX_TASKS];
+    double path_ms;
+    int length = tgraph_critical_path(graph, path, &path_ms);
+    bool critical[TGRAPH_MAX_TASKS] = {0};
+    for (int k = 0; k < length; k++) {
+        critical[path[k]] = true;
+    }
+
+    trace_event(
+        "{\"name\":\"frame %d\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":0,"
+        "\"args\":{\"critical_path_ms\":%.3f}}",
+        frame, trace_us(graph->start), trace_us(graph->end) - trace_us(graph->start), path_ms
+    );
+    for (int i = 0; i < graph->count; i++) {
+        const task* t = &graph->tasks[i];
+        trace_event(
+            "{\"name\":\"%s\",\"cat\":\"task\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,%s"
+            "\"args\":{\"frame\":%d,\"critical\":%s}}",
+            t->name, trace_us(t->start), trace_us(t->end) - trace_us(t->start), t->worker,
+            critical[i] ? "\"cname\":\"terrible\"," : "", frame, critical[i] ? "true" : "false"
+        );
+
+        // One arrow per dependency, from the end of the earlier task to the start of this one.
+        for (int d = 0; d < t->dep_count; d++) {
+            const task* dep = &graph->tasks[t->deps[d]];
+            int id = trace_flow++;
+            trace_event(
+                "{\"name\":\"dep\",\"cat\":\"dep\",\"ph\":\"s\",\"id\":%d,\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                id, trace_us(dep->end), dep->worker
+            );
+            trace_event(
+                "{\"name\":\"dep\",\"cat\":\"dep\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%d,\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                id, trace_us(t->start), t->worker
+            );
+        }
+    }
+}
+
+void tgraph_trace_close() {
+    if (trace == NULL) return;
+    fputs("\n]}\n", trace);
+    fclose(trace);
+    trace = NULL;
+}
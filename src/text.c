@@ -0,0 +1,182 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<SDL2/SDL.h>
+#include<SDL2/SDL_ttf.h>
+
+#include<app.h>
+#include<text.h>
+
+// Glyph atlas text renderer.
+// Every printable glyph of the font is rasterized once into a single texture,
+// strings are then laid out as textured quads and submitted with SDL_RenderGeometry.
+// Nothing is allocated or uploaded per frame.
+
+#define ATLAS_WIDTH 512
+#define ATLAS_PADDING 1
+// Solid white block in the top-left corner, used for background quads.
+#define ATLAS_SOLID 4
+
+typedef struct glyph {
+    SDL_Rect rect; // Cell in the atlas, full font height
+    int advance;
+} glyph;
+
+static SDL_Renderer* text_renderer = NULL;
+static SDL_Texture* atlas = NULL;
+static int atlas_w = 0;
+static int atlas_h = 0;
+static int font_height = 0;
+static glyph glyphs[TEXT_GLYPH_COUNT];
+
+static SDL_Vertex vertices[TEXT_MAX_QUADS * 4];
+static int indices[TEXT_MAX_QUADS * 6];
+static int quad_count = 0;
+
+bool text_init(SDL_Renderer* renderer, TTF_Font* font) {
+    SDL_Color white = (SDL_Color){.r = 255, .g = 255, .b = 255, .a = 255};
+    SDL_Surface* rendered[TEXT_GLYPH_COUNT];
+
+    text_renderer = renderer;
+    font_height = TTF_FontHeight(font);
+
+    // Lay glyph cells out in rows, left to right.
+    int pen_x = ATLAS_SOLID + ATLAS_PADDING;
+    int pen_y = 0;
+    int row_h = font_height;
+    for (int i = 0; i < TEXT_GLYPH_COUNT; i++) {
+        Uint16 ch = (Uint16)(TEXT_FIRST_GLYPH + i);
+        glyph* g = &glyphs[i];
+
+        int advance = 0;
+        if (TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance) != 0) {
+            advance = 0;
+        }
+        g->advance = advance;
+
+        rendered[i] = TTF_RenderGlyph_Blended(font, ch, white);
+        int w = (rendered[i] != NULL) ? rendered[i]->w : 0;
+        int h = (rendered[i] != NULL) ? rendered[i]->h : 0;
+
+        if (pen_x + w > ATLAS_WIDTH) {
+            pen_x = 0;
+            pen_y += row_h + ATLAS_PADDING;
+            row_h = font_height;
+        }
+        g->rect = (SDL_Rect){.x = pen_x, .y = pen_y, .w = w, .h = h};
+        pen_x += w + ATLAS_PADDING;
+        if (h > row_h) row_h = h;
+    }
+    atlas_w = ATLAS_WIDTH;
+    atlas_h = pen_y + row_h;
+
+    SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, atlas_w, atlas_h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surf == NULL) {
+        for (int i = 0; i < TEXT_GLYPH_COUNT; i++) SDL_FreeSurface(rendered[i]);
+        return false;
+    }
+    SDL_FillRect(surf, NULL, SDL_MapRGBA(surf->format, 255, 255, 255, 0));
+    SDL_FillRect(
+        surf,
+        &(SDL_Rect){.x = 0, .y = 0, .w = ATLAS_SOLID, .h = ATLAS_SOLID},
+        SDL_MapRGBA(surf->format, 255, 255, 255, 255)
+    );
+
+    for (int i = 0; i < TEXT_GLYPH_COUNT; i++) {
+        if (rendered[i] == NULL) continue;
+        // Copy coverage as-is instead of blending it onto the transparent atlas.
+        SDL_SetSurfaceBlendMode(rendered[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(rendered[i], NULL, surf, &glyphs[i].rect);
+        SDL_FreeSurface(rendered[i]);
+    }
+
+    atlas = SDL_CreateTextureFromSurface(renderer, surf);
+    SDL_FreeSurface(surf);
+    if (atlas == NULL) return false;
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+
+    // Index pattern never changes, fill it once.
+    for (int q = 0; q < TEXT_MAX_QUADS; q++) {
+        indices[q * 6 + 0] = q * 4 + 0;
+        indices[q * 6 + 1] = q * 4 + 1;
+        indices[q * 6 + 2] = q * 4 + 2;
+        indices[q * 6 + 3] = q * 4 + 2;
+        indices[q * 6 + 4] = q * 4 + 3;
+        indices[q * 6 + 5] = q * 4 + 0;
+    }
+    quad_count = 0;
+
+    print("Built %dx%d glyph atlas.\n", atlas_w, atlas_h);
+    return true;
+}
+
+void text_destroy() {
+    if (atlas != NULL) SDL_DestroyTexture(atlas);
+    atlas = NULL;
+    text_renderer = NULL;
+}
+
+static inline const glyph* glyph_for(char c) {
+    unsigned char ch = (unsigned char)c;
+    if (ch < TEXT_FIRST_GLYPH || ch > TEXT_LAST_GLYPH) return NULL;
+    return &glyphs[ch - TEXT_FIRST_GLYPH];
+}
+
+int text_measure(const char* text) {
+    int width = 0;
+    for (const char* c = text; *c; c++) {
+        const glyph* g = glyph_for(*c);
+        if (g != NULL) width += g->advance;
+    }
+    return width;
+}
+
+static void push_quad(float x, float y, float w, float h, SDL_Rect src, SDL_Color color) {
+    if (quad_count == TEXT_MAX_QUADS) text_flush();
+
+    float u0 = (float)src.x / atlas_w;
+    float v0 = (float)src.y / atlas_h;
+    float u1 = (float)(src.x + src.w) / atlas_w;
+    float v1 = (float)(src.y + src.h) / atlas_h;
+
+    SDL_Vertex* v = &vertices[quad_count * 4];
+    v[0] = (SDL_Vertex){.position = {x    , y    }, .color = color, .tex_coord = {u0, v0}};
+    v[1] = (SDL_Vertex){.position = {x + w, y    }, .color = color, .tex_coord = {u1, v0}};
+    v[2] = (SDL_Vertex){.position = {x + w, y + h}, .color = color, .tex_coord = {u1, v1}};
+    v[3] = (SDL_Vertex){.position = {x    , y + h}, .color = color, .tex_coord = {u0, v1}};
+    quad_count++;
+}
+
+void text_draw(const char* text, SDL_Color fg, SDL_Color bg, int x, int y, int w, int h) {
+    int natural = text_measure(text);
+    if (natural <= 0 || atlas == NULL) return;
+
+    // Same box stretching the old TTF_RenderText + SDL_RenderCopy path did.
+    float sx = (float)w / natural;
+    float sy = (float)h / font_height;
+
+    // Sample the middle of the solid block so filtering never reaches transparent texels.
+    SDL_Rect solid = (SDL_Rect){.x = 1, .y = 1, .w = ATLAS_SOLID - 2, .h = ATLAS_SOLID - 2};
+    push_quad((float)x, (float)y, (float)w, (float)h, solid, bg);
+
+    float pen = (float)x;
+    for (const char* c = text; *c; c++) {
+        const glyph* g = glyph_for(*c);
+        if (g == NULL) continue;
+        if (g->rect.w > 0) {
+            push_quad(pen, (float)y, g->rect.w * sx, g->rect.h * sy, g->rect, fg);
+        }
+        pen += g->advance * sx;
+    }
+}
+
+void text_flush() {
+    if (quad_count == 0) return;
+    SDL_RenderGeometry(
+        text_renderer,
+        atlas,
+        vertices, quad_count * 4,
+        indices, quad_count * 6
+    );
+    app->stats.draw_calls++;
+    quad_count = 0;
+}
@@ -0,0 +1,233 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<string.h>
+#include<assert.h>
+#include<malloc.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<lines.h>
+#include<raster.h>
+#include<dispatch.h>
+#include<jobs.h>
+#include<tiler.h>
+
+// Below this many edges binning runs as a single chunk.
+#define TILER_PARALLEL_MIN 4096
+
+typedef struct tiler_frame {
+    framebuffer* fb;
+    Uint32 clear;
+    int tiles_x;
+    int tiles_y;
+    int tile_count;
+
+    // Edges of every color back to back, global index g is color c while g < color_start[c + 1].
+    int color_start[LINE_COLOR_COUNT + 1];
+    const line_seg* segs[LINE_COLOR_COUNT];
+    Uint32 argb[LINE_COLOR_COUNT];
+
+    // Binning runs over fixed chunks of edges, counts are per chunk and tile, [chunk][tile].
+    int chunks;
+    int* offsets;
+    int* tile_start;    // tile_count + 1
+    Uint32* entries;    // Global edge indices, tile after tile, in push order within a tile
+    int* home;          // Per edge, the one tile it sits in, or -1 when it spans several
+} tiler_frame;
+
+static int* offsets = NULL;
+static int offsets_capacity = 0;
+static int* tile_start = NULL;
+static int tile_start_capacity = 0;
+static Uint32* entries = NULL;
+static int entries_capacity = 0;
+static int* home = NULL;
+static int home_capacity = 0;
+
+static int edge_color(const tiler_frame* t, int g) {
+    int c = 0;
+    while (g >= t->color_start[c + 1]) c++;
+    return c;
+}
+
+static line_seg edge_at(const tiler_frame* t, int g, int color) {
+    return t->segs[color][g - t->color_start[color]];
+}
+
+// Tile range of the edge's bounding box. Endpoints are whole pixels and the line kernel never
+// leaves their box, so it bounds the drawn pixels exactly.
+static void tile_range(const tiler_frame* t, line_seg s, int* tx1, int* ty1, int* tx2, int* ty2) {
+    int lo_x = (int)((s.x1 < s.x2) ? s.x1 : s.x2);
+    int hi_x = (int)((s.x1 < s.x2) ? s.x2 : s.x1);
+    int lo_y = (int)((s.y1 < s.y2) ? s.y1 : s.y2);
+    int hi_y = (int)((s.y1 < s.y2) ? s.y2 : s.y1);
+
+    *tx1 = (lo_x < 0) ? 0 : lo_x / TILE_SIZE;
+    *ty1 = (lo_y < 0) ? 0 : lo_y / TILE_SIZE;
+    *tx2 = (hi_x < 0) ? -1 : hi_x / TILE_SIZE;
+    *ty2 = (hi_y < 0) ? -1 : hi_y / TILE_SIZE;
+    if (*tx2 >= t->tiles_x) *tx2 = t->tiles_x - 1;
+    if (*ty2 >= t->tiles_y) *ty2 = t->tiles_y - 1;
+}
+
+// False when the tile, grown by a pixel, lies entirely on one side of the edge's line.
+static bool touches(line_seg s, int tx, int ty) {
+    float x0 = tx * TILE_SIZE - 1.0f;
+    float y0 = ty * TILE_SIZE - 1.0f;
+    float x1 = x0 + TILE_SIZE + 1.0f;
+    float y1 = y0 + TILE_SIZE + 1.0f;
+    float nx = s.y2 - s.y1;
+    float ny = s.x1 - s.x2;
+    float c = -(nx * s.x1 + ny * s.y1);
+
+    float d00 = nx * x0 + ny * y0 + c;
+    float d10 = nx * x1 + ny * y0 + c;
+    float d01 = nx * x0 + ny * y1 + c;
+    float d11 = nx * x1 + ny * y1 + c;
+    bool all_above = d00 > 0 && d10 > 0 && d01 > 0 && d11 > 0;
+    bool all_below = d00 < 0 && d10 < 0 && d01 < 0 && d11 < 0;
+    return !all_above && !all_below;
+}
+
+static void bin_count(void* ctx, int begin, int end, int worker) {
+    tiler_frame* t = ctx;
+    for (int chunk = begin; chunk < end; chunk++) {
+        int* counts = &t->offsets[chunk * t->tile_count];
+        memset(counts, 0, sizeof(int) * t->tile_count);
+
+        int first, last;
+        jobs_chunk_range(t->color_start[LINE_COLOR_COUNT], t->chunks, chunk, &first, &last);
+        for (int g = first; g < last; g++) {
+            line_seg s = edge_at(t, g, edge_color(t, g));
+            int tx1, ty1, tx2, ty2;
+            tile_range(t, s, &tx1, &ty1, &tx2, &ty2);
+
+            // Most edges are short and never leave their tile.
+            if (tx1 == tx2 && ty1 == ty2) {
+                t->home[g] = ty1 * t->tiles_x + tx1;
+                counts[t->home[g]]++;
+                continue;
+            }
+            t->home[g] = -1;
+            for (int ty = ty1; ty <= ty2; ty++) {
+                for (int tx = tx1; tx <= tx2; tx++) {
+                    if (touches(s, tx, ty)) counts[ty * t->tiles_x + tx]++;
+                }
+            }
+        }
+    }
+}
+
+static void bin_fill(void* ctx, int begin, int end, int worker) {
+    tiler_frame* t = ctx;
+    for (int chunk = begin; chunk < end; chunk++) {
+        int* at = &t->offsets[chunk * t->tile_count];
+
+        int first, last;
+        jobs_chunk_range(t->color_start[LINE_COLOR_COUNT], t->chunks, chunk, &first, &last);
+        for (int g = first; g < last; g++) {
+            if (t->home[g] >= 0) {
+                t->entries[at[t->home[g]]++] = (Uint32)g;
+                continue;
+            }
+
+            line_seg s = edge_at(t, g, edge_color(t, g));
+            int tx1, ty1, tx2, ty2;
+            tile_range(t, s, &tx1, &ty1, &tx2, &ty2);
+            for (int ty = ty1; ty <= ty2; ty++) {
+                for (int tx = tx1; tx <= tx2; tx++) {
+                    if (touches(s, tx, ty)) t->entries[at[ty * t->tiles_x + tx]++] = (Uint32)g;
+                }
+            }
+        }
+    }
+}
+
+static void raster_tiles(void* ctx, int begin, int end, int worker) {
+    tiler_frame* t = ctx;
+    framebuffer* fb = t->fb;
+    for (int tile = begin; tile < end; tile++) {
+        SDL_Rect rect = {
+            .x = (tile % t->tiles_x) * TILE_SIZE,
+            .y = (tile / t->tiles_x) * TILE_SIZE,
+            .w = TILE_SIZE,
+            .h = TILE_SIZE
+        };
+        if (rect.x + rect.w > fb->width) rect.w = fb->width - rect.x;
+        if (rect.y + rect.h > fb->height) rect.h = fb->height - rect.y;
+
+        for (int y = rect.y; y < rect.y + rect.h; y++) {
+            SDL_memset4(&fb->pixels[y * fb->width + rect.x], t->clear, rect.w);
+        }
+        for (int e = t->tile_start[tile]; e < t->tile_start[tile + 1]; e++) {
+            int g = (int)t->entries[e];
+            int c = edge_color(t, g);
+            line_seg s = edge_at(t, g, c);
+            kern.raster_line(fb, (int)s.x1, (int)s.y1, (int)s.x2, (int)s.y2, t->argb[c], rect);
+        }
+    }
+}
+
+int tiler_flush(framebuffer* fb, Uint32 clear_argb) {
+    tiler_frame t = {
+        .fb = fb,
+        .clear = clear_argb,
+        .tiles_x = (fb->width + TILE_SIZE - 1) / TILE_SIZE,
+        .tiles_y = (fb->height + TILE_SIZE - 1) / TILE_SIZE
+    };
+    t.tile_count = t.tiles_x * t.tiles_y;
+
+    t.color_start[0] = 0;
+    for (int c = 0; c < LINE_COLOR_COUNT; c++) {
+        int count;
+        t.segs[c] = lines_segments(c, &count);
+        t.argb[c] = lines_color_argb(c);
+        t.color_start[c + 1] = t.color_start[c] + count;
+    }
+    int edges = t.color_start[LINE_COLOR_COUNT];
+    t.chunks = (edges >= TILER_PARALLEL_MIN) ? jobs_thread_count() * 4 : 1;
+
+    if (t.chunks * t.tile_count > offsets_capacity) {
+        offsets_capacity = t.chunks * t.tile_count;
+        offsets = realloc(offsets, sizeof(int) * offsets_capacity);
+        assert(offsets != NULL);
+    }
+    if (t.tile_count + 1 > tile_start_capacity) {
+        tile_start_capacity = t.tile_count + 1;
+        tile_start = realloc(tile_start, sizeof(int) * tile_start_capacity);
+        assert(tile_start != NULL);
+    }
+    if (edges > home_capacity) {
+        home_capacity = edges * 2;
+        home = realloc(home, sizeof(int) * home_capacity);
+        assert(home != NULL);
+    }
+    t.offsets = offsets;
+    t.tile_start = tile_start;
+    t.home = home;
+
+    jobs_parallel_for(t.chunks, t.chunks, bin_count, &t);
+
+    // Tile by tile, chunk by chunk, so every tile lists its edges in push order.
+    int total = 0;
+    for (int tile = 0; tile < t.tile_count; tile++) {
+        t.tile_start[tile] = total;
+        for (int chunk = 0; chunk < t.chunks; chunk++) {
+            int n = t.offsets[chunk * t.tile_count + tile];
+            t.offsets[chunk * t.tile_count + tile] = total;
+            total += n;
+        }
+    }
+    t.tile_start[t.tile_count] = total;
+
+    if (total > entries_capacity) {
+        entries_capacity = total * 2;
+        entries = realloc(entries, sizeof(Uint32) * entries_capacity);
+        assert(entries != NULL);
+    }
+    t.entries = entries;
+
+    jobs_parallel_for(t.chunks, t.chunks, bin_fill, &t);
+    jobs_parallel_for(t.tile_count, t.tile_count, raster_tiles, &t);
+    return total;
+}
@@ -0,0 +1,225 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<dispatch.h>
+#include<trig.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include<immintrin.h>
+#define TRIG_X86
+#endif
+
+#define TABLE_SIZE 256
+#define SWEEP_SAMPLES 100003
+
+enum TrigTier trig_tier = TRIG_LIBM;
+
+static const char* tier_names[TRIG_TIER_COUNT] = {
+    [TRIG_TABLE] = "table",
+    [TRIG_POLY] = "poly",
+    [TRIG_LIBM] = "libm"
+};
+
+// sin over one turn, plus a wrap-around entry so interpolation never needs a bounds check.
+static double table[TABLE_SIZE + 1];
+static bool table_ready = false;
+
+static void build_table() {
+    for (int i = 0; i <= TABLE_SIZE; i++) {
+        table[i] = sin(i * (2 * M_PI / TABLE_SIZE));
+    }
+    table_ready = true;
+}
+
+static inline double table_lookup(double turns) {
+    double t = turns * TABLE_SIZE;
+    double i = floor(t);
+    double f = t - i;
+    int index = (int)((long long)i & (TABLE_SIZE - 1));
+    return table[index] + f * (table[index + 1] - table[index]);
+}
+
+static void table_sincos(double x, double* s, double* c) {
+    if (!table_ready) build_table();
+    double turns = x * (1 / (2 * M_PI));
+    *s = table_lookup(turns);
+    *c = table_lookup(turns + 0.25);
+}
+
+// Cody-Waite split of pi/2, the first part has enough trailing zeros that k * PIO2_HI is exact.
+#define PIO2_HI 1.57079632673412561417e+00
+#define PIO2_LO 6.07710050650619224932e-11
+
+// Minimax coefficients on [-pi/4, pi/4] (cephes sinf/cosf).
+#define S1 -1.6666654611e-1
+#define S2 8.3321608736e-3
+#define S3 -1.9515295891e-4
+#define C1 4.166664568298827e-2
+#define C2 -1.388731625493765e-3
+#define C3 2.443315711809948e-5
+
+static void poly_sincos(double x, double* s, double* c) {
+    double k = nearbyint(x * M_2_PI);
+    double r = (x - k * PIO2_HI) - k * PIO2_LO;
+    double r2 = r * r;
+
+    double ps = r + r * r2 * (S1 + r2 * (S2 + r2 * S3));
+    double pc = 1.0 - 0.5 * r2 + r2 * r2 * (C1 + r2 * (C2 + r2 * C3));
+
+    // Rotate the reduced result back into its quadrant.
+    switch ((long long)k & 3) {
+        case 0: *s = ps;  *c = pc;  break;
+        case 1: *s = pc;  *c = -ps; break;
+        case 2: *s = -ps; *c = -pc; break;
+        default: *s = -pc; *c = ps; break;
+    }
+}
+
+void trig_poly_batch_scalar(const double* x, double* s, double* c, int count) {
+    for (int i = 0; i < count; i++) {
+        poly_sincos(x[i], &s[i], &c[i]);
+    }
+}
+
+#ifdef TRIG_X86
+
+__attribute__((target("avx2")))
+void trig_poly_batch_avx2(const double* x, double* s, double* c, int count) {
+    const __m256d two_over_pi = _mm256_set1_pd(M_2_PI);
+    const __m256d pio2_hi = _mm256_set1_pd(PIO2_HI);
+    const __m256d pio2_lo = _mm256_set1_pd(PIO2_LO);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256i bit0 = _mm256_set1_epi64x(1);
+    const __m256i bit1 = _mm256_set1_epi64x(2);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d vx = _mm256_loadu_pd(&x[i]);
+        __m256d k = _mm256_round_pd(_mm256_mul_pd(vx, two_over_pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_sub_pd(_mm256_sub_pd(vx, _mm256_mul_pd(k, pio2_hi)), _mm256_mul_pd(k, pio2_lo));
+        __m256d r2 = _mm256_mul_pd(r, r);
+
+        __m256d ps = _mm256_add_pd(_mm256_set1_pd(S2), _mm256_mul_pd(r2, _mm256_set1_pd(S3)));
+        ps = _mm256_add_pd(_mm256_set1_pd(S1), _mm256_mul_pd(r2, ps));
+        ps = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, r2), ps));
+
+        __m256d pc = _mm256_add_pd(_mm256_set1_pd(C2), _mm256_mul_pd(r2, _mm256_set1_pd(C3)));
+        pc = _mm256_add_pd(_mm256_set1_pd(C1), _mm256_mul_pd(r2, pc));
+        pc = _mm256_add_pd(
+            _mm256_sub_pd(one, _mm256_mul_pd(half, r2)),
+            _mm256_mul_pd(_mm256_mul_pd(r2, r2), pc)
+        );
+
+        // Quadrant q = k & 3: odd quadrants swap sin and cos, q 2/3 negate sin, q 1/2 negate cos.
+        __m256i q = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k));
+        __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(q, bit0), bit0));
+        __m256d neg_s = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(q, bit1), bit1));
+        __m256d neg_c = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(_mm256_add_epi64(q, bit0), bit1), bit1));
+
+        __m256d vs = _mm256_blendv_pd(ps, pc, swap);
+        __m256d vc = _mm256_blendv_pd(pc, ps, swap);
+        vs = _mm256_xor_pd(vs, _mm256_and_pd(neg_s, sign));
+        vc = _mm256_xor_pd(vc, _mm256_and_pd(neg_c, sign));
+
+        _mm256_storeu_pd(&s[i], vs);
+        _mm256_storeu_pd(&c[i], vc);
+    }
+    trig_poly_batch_scalar(&x[i], &s[i], &c[i], count - i);
+}
+
+#else
+
+void trig_poly_batch_avx2(const double* x, double* s, double* c, int count) {
+    trig_poly_batch_scalar(x, s, c, count);
+}
+
+#endif // TRIG_X86
+
+void trig_sincos(enum TrigTier tier, double x, double* s, double* c) {
+    switch (tier) {
+        case TRIG_TABLE:
+            table_sincos(x, s, c);
+            break;
+        case TRIG_POLY:
+            poly_sincos(x, s, c);
+            break;
+        default:
+            *s = sin(x);
+            *c = cos(x);
+            break;
+    }
+}
+
+void trig_sincos_batch(enum TrigTier tier, const double* x, double* s, double* c, int count) {
+    if (tier == TRIG_POLY) {
+        kern.sincos_poly(x, s, c, count);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        trig_sincos(tier, x[i], &s[i], &c[i]);
+    }
+}
+
+double trig_max_error(enum TrigTier tier) {
+    double worst = 0.0;
+    // Two turns either side of zero, where scene angles live.
+    for (int i = 0; i < SWEEP_SAMPLES; i++) {
+        double x = -4 * M_PI + (8 * M_PI) * i / (SWEEP_SAMPLES - 1);
+        double s, c;
+        trig_sincos(tier, x, &s, &c);
+        worst = fmax(worst, fmax(fabs(s - sin(x)), fabs(c - cos(x))));
+    }
+    return worst;
+}
+
+double trig_pixel_error(double error, int screen_width, int screen_height) {
+    return 3.0 * error * hypot(screen_width, screen_height);
+}
+
+// Best of a few timed batches, in ns per angle. Which tier is cheapest depends on the kernels
+// the dispatcher picked, a vectorized polynomial beats the table's scalar lookups.
+static double tier_cost(enum TrigTier tier) {
+    enum { samples = 4096 };
+    static double x[samples], s[samples], c[samples];
+    for (int i = 0; i < samples; i++) {
+        x[i] = -4 * M_PI + (8 * M_PI) * i / samples;
+    }
+
+    double best = INFINITY;
+    for (int round = 0; round < 5; round++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        trig_sincos_batch(tier, x, s, c, samples);
+        double ns = (double)(SDL_GetPerformanceCounter() - start) * 1e9 / SDL_GetPerformanceFrequency() / samples;
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+enum TrigTier trig_select(int screen_width, int screen_height, double max_pixels) {
+    trig_tier = TRIG_LIBM;
+    double cheapest = tier_cost(TRIG_LIBM);
+    for (int tier = 0; tier < TRIG_LIBM; tier++) {
+        double pixels = trig_pixel_error(trig_max_error(tier), screen_width, screen_height);
+        if (pixels >= max_pixels) continue;
+
+        double cost = tier_cost(tier);
+        if (cost < cheapest) {
+            trig_tier = tier;
+            cheapest = cost;
+        }
+    }
+    print("Using %s trig (%.4f px worst case at %dx%d).\n",
+        tier_names[trig_tier],
+        trig_pixel_error(trig_max_error(trig_tier), screen_width, screen_height),
+        screen_width, screen_height);
+    return trig_tier;
+}
+
+const char* trig_tier_name(enum TrigTier tier) {
+    return (tier >= 0 && tier < TRIG_TIER_COUNT) ? tier_names[tier] : "unknown";
+}
@@ -0,0 +1,195 @@
+#include<math.h>
+
+#include<vmath.h>
+
+m3 m3_identity() {
+    return (m3){.m = {
+        1, 0, 0,
+        0, 1, 0,
+        0, 0, 1
+    }};
+}
+
+m3 m3_mul(m3 a, m3 b) {
+    m3 r;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            r.m[row * 3 + col] =
+                a.m[row * 3 + 0] * b.m[0 * 3 + col] +
+                a.m[row * 3 + 1] * b.m[1 * 3 + col] +
+                a.m[row * 3 + 2] * b.m[2 * 3 + col];
+        }
+    }
+    return r;
+}
+
+v3 m3_mul_v3(m3 a, v3 v) {
+    return (v3){
+        .x = a.m[0] * v.x + a.m[1] * v.y + a.m[2] * v.z,
+        .y = a.m[3] * v.x + a.m[4] * v.y + a.m[5] * v.z,
+        .z = a.m[6] * v.x + a.m[7] * v.y + a.m[8] * v.z
+    };
+}
+
+m3 m3_transpose(m3 a) {
+    return (m3){.m = {
+        a.m[0], a.m[3], a.m[6],
+        a.m[1], a.m[4], a.m[7],
+        a.m[2], a.m[5], a.m[8]
+    }};
+}
+
+m3 m3_rotation_xyz(double rot_x, double rot_y, double rot_z) {
+    return m3_rotation_xyz_sc(
+        (v3){.x = sin(rot_x), .y = sin(rot_y), .z = sin(rot_z)},
+        (v3){.x = cos(rot_x), .y = cos(rot_y), .z = cos(rot_z)}
+    );
+}
+
+m3 m3_rotation_xyz_sc(v3 s, v3 c) {
+    // Rz * Ry * Rx expanded, with Ry using v_rotate_y's sign convention.
+    return (m3){.m = {
+        c.z * c.y, -c.z * s.y * s.x - s.z * c.x, -c.z * s.y * c.x + s.z * s.x,
+        s.z * c.y, -s.z * s.y * s.x + c.z * c.x, -s.z * s.y * c.x - c.z * s.x,
+        s.y      , c.y * s.x                   , c.y * c.x
+    }};
+}
+
+m4 m4_identity() {
+    return (m4){.m = {
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 0, 1
+    }};
+}
+
+m4 m4_mul(m4 a, m4 b) {
+    m4 r;
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            double sum = 0.0;
+            for (int k = 0; k < 4; k++) {
+                sum += a.m[row * 4 + k] * b.m[k * 4 + col];
+            }
+            r.m[row * 4 + col] = sum;
+        }
+    }
+    return r;
+}
+
+v3 m4_mul_point(m4 a, v3 p) {
+    return (v3){
+        .x = a.m[0] * p.x + a.m[1] * p.y + a.m[2] * p.z + a.m[3],
+        .y = a.m[4] * p.x + a.m[5] * p.y + a.m[6] * p.z + a.m[7],
+        .z = a.m[8] * p.x + a.m[9] * p.y + a.m[10] * p.z + a.m[11]
+    };
+}
+
+m4 m4_affine(m3 r, v3 t, v3 s) {
+    return (m4){.m = {
+        r.m[0] * s.x, r.m[1] * s.y, r.m[2] * s.z, t.x,
+        r.m[3] * s.x, r.m[4] * s.y, r.m[5] * s.z, t.y,
+        r.m[6] * s.x, r.m[7] * s.y, r.m[8] * s.z, t.z,
+        0           , 0           , 0           , 1
+    }};
+}
+
+m34f m4_to_m34f(m4 a) {
+    m34f r;
+    for (int i = 0; i < 12; i++) {
+        r.m[i] = (float)a.m[i];
+    }
+    return r;
+}
+
+quat quat_identity() {
+    return (quat){.w = 1, .x = 0, .y = 0, .z = 0};
+}
+
+quat quat_axis_angle(v3 axis, double angle) {
+    double s = sin(angle / 2);
+    return (quat){.w = cos(angle / 2), .x = axis.x * s, .y = axis.y * s, .z = axis.z * s};
+}
+
+quat quat_mul(quat a, quat b) {
+    return (quat){
+        .w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        .x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        .y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        .z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+    };
+}
+
+quat quat_normalize(quat q) {
+    double len = sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    if (len == 0.0) return quat_identity();
+    return (quat){.w = q.w / len, .x = q.x / len, .y = q.y / len, .z = q.z / len};
+}
+
+quat quat_conjugate(quat q) {
+    return (quat){.w = q.w, .x = -q.x, .y = -q.y, .z = -q.z};
+}
+
+v3 quat_rotate(quat q, v3 v) {
+    return m3_mul_v3(quat_to_m3(q), v);
+}
+
+m3 quat_to_m3(quat q) {
+    double xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    double xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    double wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    return (m3){.m = {
+        1 - 2 * (yy + zz), 2 * (xy - wz)    , 2 * (xz + wy),
+        2 * (xy + wz)    , 1 - 2 * (xx + zz), 2 * (yz - wx),
+        2 * (xz - wy)    , 2 * (yz + wx)    , 1 - 2 * (xx + yy)
+    }};
+}
+
+quat quat_from_m3(m3 a) {
+    // Shepperd's method, branch on the largest diagonal term for stability.
+    double trace = a.m[0] + a.m[4] + a.m[8];
+    quat q;
+    if (trace > 0) {
+        double s = sqrt(trace + 1.0) * 2;
+        q = (quat){.w = s / 4, .x = (a.m[7] - a.m[5]) / s, .y = (a.m[2] - a.m[6]) / s, .z = (a.m[3] - a.m[1]) / s};
+    } else if (a.m[0] > a.m[4] && a.m[0] > a.m[8]) {
+        double s = sqrt(1.0 + a.m[0] - a.m[4] - a.m[8]) * 2;
+        q = (quat){.w = (a.m[7] - a.m[5]) / s, .x = s / 4, .y = (a.m[1] + a.m[3]) / s, .z = (a.m[2] + a.m[6]) / s};
+    } else if (a.m[4] > a.m[8]) {
+        double s = sqrt(1.0 + a.m[4] - a.m[0] - a.m[8]) * 2;
+        q = (quat){.w = (a.m[2] - a.m[6]) / s, .x = (a.m[1] + a.m[3]) / s, .y = s / 4, .z = (a.m[5] + a.m[7]) / s};
+    } else {
+        double s = sqrt(1.0 + a.m[8] - a.m[0] - a.m[4]) * 2;
+        q = (quat){.w = (a.m[3] - a.m[1]) / s, .x = (a.m[2] + a.m[6]) / s, .y = (a.m[5] + a.m[7]) / s, .z = s / 4};
+    }
+    return quat_normalize(q);
+}
+
+quat quat_slerp(quat a, quat b, double t) {
+    double d = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+    // Take the short way round.
+    if (d < 0) {
+        b = (quat){.w = -b.w, .x = -b.x, .y = -b.y, .z = -b.z};
+        d = -d;
+    }
+
+    double wa, wb;
+    if (d > 0.9995) {
+        // Nearly parallel, lerp is accurate and avoids dividing by sin(~0).
+        wa = 1 - t;
+        wb = t;
+    } else {
+        double theta = acos(d);
+        double s = sin(theta);
+        wa = sin((1 - t) * theta) / s;
+        wb = sin(t * theta) / s;
+    }
+    return quat_normalize((quat){
+        .w = wa * a.w + wb * b.w,
+        .x = wa * a.x + wb * b.x,
+        .y = wa * a.y + wb * b.y,
+        .z = wa * a.z + wb * b.z
+    });
+}
@@ -0,0 +1,201 @@
+#include<stdio.h>
+#include<stdbool.h>
+#include<math.h>
+#include<SDL2/SDL.h>
+
+#include<app.h>
+#include<vmath.h>
+#include<xform.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include<immintrin.h>
+#define XFORM_X86
+#endif
+
+void xform_cubes_scalar(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z) {
+    for (int i = 0; i < count; i++) {
+        const float* m = model[first + i].m;
+
+        for (int k = 0; k < CUBE_CORNERS; k++) {
+            double lx = (k & 1) ? 1.0 : -1.0;
+            double ly = (k & 2) ? 1.0 : -1.0;
+            double lz = (k & 4) ? 1.0 : -1.0;
+
+            out_x[i * CUBE_CORNERS + k] = (float)(m[0] * lx + m[1] * ly + m[2] * lz + m[3]);
+            out_y[i * CUBE_CORNERS + k] = (float)(m[4] * lx + m[5] * ly + m[6] * lz + m[7]);
+            out_z[i * CUBE_CORNERS + k] = (float)(m[8] * lx + m[9] * ly + m[10] * lz + m[11]);
+        }
+    }
+}
+
+void xform_points_scalar(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z) {
+    const float* m = model->m;
+    for (int i = 0; i < count; i++) {
+        double lx = x[i];
+        double ly = y[i];
+        double lz = z[i];
+
+        out_x[i] = (float)(m[0] * lx + m[1] * ly + m[2] * lz + m[3]);
+        out_y[i] = (float)(m[4] * lx + m[5] * ly + m[6] * lz + m[7]);
+        out_z[i] = (float)(m[8] * lx + m[9] * ly + m[10] * lz + m[11]);
+    }
+}
+
+void project_scalar(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y) {
+    for (int i = 0; i < count; i++) {
+        double scale = fov / (fov + z[i]);
+        out_x[i] = (float)(x[i] * scale);
+        out_y[i] = (float)(y[i] * scale);
+    }
+}
+
+#ifdef XFORM_X86
+
+// The SIMD transform kernels put the 8 corners of one cube in lanes, so they need no gathers:
+// every matrix entry is broadcast, the corner signs are constants.
+
+__attribute__((target("sse2")))
+void xform_cubes_sse2(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z) {
+    // Corners 0-3 and 4-7 only differ in the z sign.
+    const __m128 sign_x = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    const __m128 sign_y = _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+
+    for (int i = 0; i < count; i++) {
+        const float* m = model[first + i].m;
+
+        int at = i * CUBE_CORNERS;
+        float* outs[3] = {out_x, out_y, out_z};
+        for (int r = 0; r < 3; r++) {
+            __m128 xy = _mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(m[r * 4 + 0]), sign_x),
+                _mm_mul_ps(_mm_set1_ps(m[r * 4 + 1]), sign_y)
+            );
+            _mm_storeu_ps(&outs[r][at], _mm_add_ps(xy, _mm_set1_ps(m[r * 4 + 3] - m[r * 4 + 2])));
+            _mm_storeu_ps(&outs[r][at + 4], _mm_add_ps(xy, _mm_set1_ps(m[r * 4 + 3] + m[r * 4 + 2])));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void xform_cubes_avx2(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z) {
+    const __m256 sign_x = _mm256_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+    const __m256 sign_y = _mm256_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f);
+    const __m256 sign_z = _mm256_setr_ps(-1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+
+    for (int i = 0; i < count; i++) {
+        const float* m = model[first + i].m;
+
+        #define ROW(r) \
+            _mm256_add_ps( \
+                _mm256_add_ps( \
+                    _mm256_mul_ps(_mm256_set1_ps(m[r * 4 + 0]), sign_x), \
+                    _mm256_mul_ps(_mm256_set1_ps(m[r * 4 + 1]), sign_y) \
+                ), \
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[r * 4 + 2]), sign_z), _mm256_set1_ps(m[r * 4 + 3])) \
+            )
+        _mm256_storeu_ps(&out_x[i * CUBE_CORNERS], ROW(0));
+        _mm256_storeu_ps(&out_y[i * CUBE_CORNERS], ROW(1));
+        _mm256_storeu_ps(&out_z[i * CUBE_CORNERS], ROW(2));
+        #undef ROW
+    }
+}
+
+// Arbitrary meshes put consecutive vertices in lanes instead, with the matrix broadcast once.
+
+__attribute__((target("sse2")))
+void xform_points_sse2(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z) {
+    const float* m = model->m;
+    __m128 row[12];
+    for (int k = 0; k < 12; k++) row[k] = _mm_set1_ps(m[k]);
+
+    float* outs[3] = {out_x, out_y, out_z};
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 lx = _mm_loadu_ps(&x[i]);
+        __m128 ly = _mm_loadu_ps(&y[i]);
+        __m128 lz = _mm_loadu_ps(&z[i]);
+        for (int r = 0; r < 3; r++) {
+            __m128 v = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(row[r * 4 + 0], lx), _mm_mul_ps(row[r * 4 + 1], ly)),
+                _mm_add_ps(_mm_mul_ps(row[r * 4 + 2], lz), row[r * 4 + 3])
+            );
+            _mm_storeu_ps(&outs[r][i], v);
+        }
+    }
+    xform_points_scalar(model, &x[i], &y[i], &z[i], count - i, &out_x[i], &out_y[i], &out_z[i]);
+}
+
+__attribute__((target("avx2")))
+void xform_points_avx2(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z) {
+    const float* m = model->m;
+    __m256 row[12];
+    for (int k = 0; k < 12; k++) row[k] = _mm256_set1_ps(m[k]);
+
+    float* outs[3] = {out_x, out_y, out_z};
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 lx = _mm256_loadu_ps(&x[i]);
+        __m256 ly = _mm256_loadu_ps(&y[i]);
+        __m256 lz = _mm256_loadu_ps(&z[i]);
+        for (int r = 0; r < 3; r++) {
+            __m256 v = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(row[r * 4 + 0], lx), _mm256_mul_ps(row[r * 4 + 1], ly)),
+                _mm256_add_ps(_mm256_mul_ps(row[r * 4 + 2], lz), row[r * 4 + 3])
+            );
+            _mm256_storeu_ps(&outs[r][i], v);
+        }
+    }
+    xform_points_scalar(model, &x[i], &y[i], &z[i], count - i, &out_x[i], &out_y[i], &out_z[i]);
+}
+
+__attribute__((target("sse2")))
+void project_sse2(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y) {
+    const __m128 vfov = _mm_set1_ps((float)fov);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 scale = _mm_div_ps(vfov, _mm_add_ps(vfov, _mm_loadu_ps(&z[i])));
+        _mm_storeu_ps(&out_x[i], _mm_mul_ps(_mm_loadu_ps(&x[i]), scale));
+        _mm_storeu_ps(&out_y[i], _mm_mul_ps(_mm_loadu_ps(&y[i]), scale));
+    }
+    project_scalar(&x[i], &y[i], &z[i], count - i, fov, &out_x[i], &out_y[i]);
+}
+
+__attribute__((target("avx2")))
+void project_avx2(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y) {
+    const __m256 vfov = _mm256_set1_ps((float)fov);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 scale = _mm256_div_ps(vfov, _mm256_add_ps(vfov, _mm256_loadu_ps(&z[i])));
+        _mm256_storeu_ps(&out_x[i], _mm256_mul_ps(_mm256_loadu_ps(&x[i]), scale));
+        _mm256_storeu_ps(&out_y[i], _mm256_mul_ps(_mm256_loadu_ps(&y[i]), scale));
+    }
+    project_scalar(&x[i], &y[i], &z[i], count - i, fov, &out_x[i], &out_y[i]);
+}
+
+#else
+
+void xform_cubes_sse2(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z) {
+    xform_cubes_scalar(model, first, count, out_x, out_y, out_z);
+}
+
+void xform_cubes_avx2(const m34f* model, int first, int count, float* out_x, float* out_y, float* out_z) {
+    xform_cubes_scalar(model, first, count, out_x, out_y, out_z);
+}
+
+void xform_points_sse2(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z) {
+    xform_points_scalar(model, x, y, z, count, out_x, out_y, out_z);
+}
+
+void xform_points_avx2(const m34f* model, const float* x, const float* y, const float* z, int count, float* out_x, float* out_y, float* out_z) {
+    xform_points_scalar(model, x, y, z, count, out_x, out_y, out_z);
+}
+
+void project_sse2(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y) {
+    project_scalar(x, y, z, count, fov, out_x, out_y);
+}
+
+void project_avx2(const float* x, const float* y, const float* z, int count, double fov, float* out_x, float* out_y) {
+    project_scalar(x, y, z, count, fov, out_x, out_y);
+}
+
+#endif // XFORM_X86